@@ -0,0 +1,742 @@
+/*
+ Copyright (c) 2017, Joel Levin
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ 
+ Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ Neither the name of JLRoutes nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ JLRoutesBenchmark measures routing, request parsing, optional route expansion and route registration across
+ route counts, pattern shapes and hit/miss mixes. Every measurement is written as one line of JSON (or CSV) on
+ stdout, so runs can be compared by script. See the Makefile in this directory for building on Linux with GNUstep.
+ 
+ Usage: JLRoutesBenchmark [--cases a,b] [--shapes a,b] [--counts 10,100] [--hit-ratios 1,0.5,0] [--operations n] [--format json|csv]
+ 
+ With --replay, a trace recorded by JLRRouteRecorder is routed instead, with every handler stubbed, against each of the
+ given route tables in turn. A route table is either a file, loaded into the global routes, or a directory of
+ <scheme>.table files (with JLRoutesGlobalRoutesScheme.table for the global routes). For each one, a line reports
+ throughput and latency percentiles over the whole trace, followed by a line for each route with its share of the time.
+ Replaying the same trace with two builds of this benchmark compares the builds.
+ 
+ Usage: JLRoutesBenchmark --replay trace.txt --tables before.table,after.table [--fingerprint f] [--format json|csv]
+ */
+
+#import <Foundation/Foundation.h>
+#import <stdio.h>
+#import <stdlib.h>
+#import <string.h>
+#import <time.h>
+#import "JLRoutes.h"
+
+
+#pragma mark - Allocation Counting
+
+// Counting every malloc lets allocations/op cover Foundation and runtime allocations, not just the ones made here.
+// This works by interposing the glibc allocator, so allocation counts are only reported on Linux.
+
+static unsigned long long JLRBenchmark_allocationCount = 0;
+
+#if defined(__GLIBC__)
+
+#define JLRBENCHMARK_COUNTS_ALLOCATIONS 1
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t count, size_t size);
+extern void *__libc_realloc(void *pointer, size_t size);
+
+void *malloc(size_t size)
+{
+    __atomic_fetch_add(&JLRBenchmark_allocationCount, 1, __ATOMIC_RELAXED);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size)
+{
+    __atomic_fetch_add(&JLRBenchmark_allocationCount, 1, __ATOMIC_RELAXED);
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *pointer, size_t size)
+{
+    __atomic_fetch_add(&JLRBenchmark_allocationCount, 1, __ATOMIC_RELAXED);
+    return __libc_realloc(pointer, size);
+}
+
+#else
+
+#define JLRBENCHMARK_COUNTS_ALLOCATIONS 0
+
+#endif
+
+static unsigned long long JLRBenchmarkAllocationCount(void)
+{
+    return __atomic_load_n(&JLRBenchmark_allocationCount, __ATOMIC_RELAXED);
+}
+
+
+#pragma mark - Timing
+
+static unsigned long long JLRBenchmarkNow(void)
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (unsigned long long)time.tv_sec * 1000000000ULL + (unsigned long long)time.tv_nsec;
+}
+
+static int JLRBenchmarkCompareSamples(const void *first, const void *second)
+{
+    unsigned long long a = *(const unsigned long long *)first;
+    unsigned long long b = *(const unsigned long long *)second;
+    return (a > b) - (a < b);
+}
+
+// A small deterministic generator, so every run picks the same URLs.
+static unsigned long long JLRBenchmarkRandom(unsigned long long *state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+
+#pragma mark - Configuration
+
+typedef NS_ENUM(NSUInteger, JLRBenchmarkFormat) {
+    JLRBenchmarkFormatJSON,
+    JLRBenchmarkFormatCSV
+};
+
+
+@interface JLRBenchmarkConfiguration : NSObject
+
+@property (nonatomic, copy) NSArray <NSString *> *cases;
+@property (nonatomic, copy) NSArray <NSString *> *shapes;
+@property (nonatomic, copy) NSArray <NSNumber *> *routeCounts;
+@property (nonatomic, copy) NSArray <NSNumber *> *hitRatios;
+@property (nonatomic, assign) NSUInteger operations;
+@property (nonatomic, assign) JLRBenchmarkFormat format;
+@property (nonatomic, copy) NSString *replayTracePath;
+@property (nonatomic, copy) NSArray <NSString *> *routeTablePaths;
+@property (nonatomic, copy) NSString *fingerprint;
+
++ (instancetype)configurationWithArguments:(NSArray <NSString *> *)arguments;
+
+@end
+
+
+@implementation JLRBenchmarkConfiguration
+
++ (instancetype)configurationWithArguments:(NSArray <NSString *> *)arguments
+{
+    JLRBenchmarkConfiguration *configuration = [[self alloc] init];
+    configuration.cases = @[@"routeURL", @"canRouteURL", @"parseRequest", @"expandOptional", @"register"];
+    configuration.shapes = @[@"static", @"variable", @"wildcard", @"optional"];
+    configuration.routeCounts = @[@10, @100, @1000, @10000, @100000];
+    configuration.hitRatios = @[@1, @0.5, @0];
+    configuration.operations = 20000;
+    configuration.format = JLRBenchmarkFormatJSON;
+    configuration.routeTablePaths = @[];
+    configuration.fingerprint = @"";
+    
+    for (NSUInteger index = 1; index + 1 < arguments.count; index += 2) {
+        NSString *option = arguments[index];
+        NSString *value = arguments[index + 1];
+        NSArray <NSString *> *values = [value componentsSeparatedByString:@","];
+        
+        if ([option isEqualToString:@"--cases"]) {
+            configuration.cases = values;
+        } else if ([option isEqualToString:@"--shapes"]) {
+            configuration.shapes = values;
+        } else if ([option isEqualToString:@"--counts"]) {
+            configuration.routeCounts = [self _numbersFromStrings:values];
+        } else if ([option isEqualToString:@"--hit-ratios"]) {
+            configuration.hitRatios = [self _numbersFromStrings:values];
+        } else if ([option isEqualToString:@"--operations"]) {
+            configuration.operations = (NSUInteger)MAX([value integerValue], 1);
+        } else if ([option isEqualToString:@"--format"]) {
+            configuration.format = [value isEqualToString:@"csv"] ? JLRBenchmarkFormatCSV : JLRBenchmarkFormatJSON;
+        } else if ([option isEqualToString:@"--replay"]) {
+            configuration.replayTracePath = value;
+        } else if ([option isEqualToString:@"--tables"]) {
+            configuration.routeTablePaths = values;
+        } else if ([option isEqualToString:@"--fingerprint"]) {
+            configuration.fingerprint = value;
+        } else {
+            fprintf(stderr, "unknown option %s\n", option.UTF8String);
+            exit(1);
+        }
+    }
+    
+    if (configuration.replayTracePath != nil && configuration.routeTablePaths.count == 0) {
+        fprintf(stderr, "--replay needs at least one route table in --tables\n");
+        exit(1);
+    }
+    
+    return configuration;
+}
+
++ (NSArray <NSNumber *> *)_numbersFromStrings:(NSArray <NSString *> *)strings
+{
+    NSMutableArray <NSNumber *> *numbers = [NSMutableArray array];
+    for (NSString *string in strings) {
+        [numbers addObject:@([string doubleValue])];
+    }
+    return [numbers copy];
+}
+
+@end
+
+
+#pragma mark - Results
+
+@interface JLRBenchmarkResult : NSObject
+
+@property (nonatomic, copy) NSString *benchmarkCase;
+@property (nonatomic, copy) NSString *shape;
+@property (nonatomic, assign) NSUInteger routeCount;
+@property (nonatomic, assign) double hitRatio;
+@property (nonatomic, assign) NSUInteger operations;
+@property (nonatomic, assign) double nanosecondsPerOperation;
+@property (nonatomic, assign) double allocationsPerOperation;
+@property (nonatomic, assign) unsigned long long p50;
+@property (nonatomic, assign) unsigned long long p90;
+@property (nonatomic, assign) unsigned long long p99;
+
+- (void)printWithFormat:(JLRBenchmarkFormat)format;
+
+@end
+
+
+@implementation JLRBenchmarkResult
+
++ (void)printHeaderWithFormat:(JLRBenchmarkFormat)format
+{
+    if (format == JLRBenchmarkFormatCSV) {
+        printf("case,shape,routes,hit_ratio,operations,ns_per_op,allocs_per_op,p50_ns,p90_ns,p99_ns\n");
+    }
+}
+
+- (void)printWithFormat:(JLRBenchmarkFormat)format
+{
+    // allocations are reported as -1 where they can't be counted
+    double allocationsPerOperation = JLRBENCHMARK_COUNTS_ALLOCATIONS ? self.allocationsPerOperation : -1;
+    
+    if (format == JLRBenchmarkFormatCSV) {
+        printf("%s,%s,%lu,%g,%lu,%.1f,%.2f,%llu,%llu,%llu\n", self.benchmarkCase.UTF8String, self.shape.UTF8String, (unsigned long)self.routeCount, self.hitRatio, (unsigned long)self.operations, self.nanosecondsPerOperation, allocationsPerOperation, self.p50, self.p90, self.p99);
+    } else {
+        printf("{\"case\":\"%s\",\"shape\":\"%s\",\"routes\":%lu,\"hit_ratio\":%g,\"operations\":%lu,\"ns_per_op\":%.1f,\"allocs_per_op\":%.2f,\"p50_ns\":%llu,\"p90_ns\":%llu,\"p99_ns\":%llu}\n", self.benchmarkCase.UTF8String, self.shape.UTF8String, (unsigned long)self.routeCount, self.hitRatio, (unsigned long)self.operations, self.nanosecondsPerOperation, allocationsPerOperation, self.p50, self.p90, self.p99);
+    }
+    
+    fflush(stdout);
+}
+
+@end
+
+
+// A line of replay output: the whole trace against one route table (case "replay"), or one route of it (case "replayRoute").
+@interface JLRBenchmarkReplayResult : NSObject
+
+@property (nonatomic, copy) NSString *benchmarkCase;
+@property (nonatomic, copy) NSString *table;
+@property (nonatomic, copy) NSString *pattern;
+@property (nonatomic, assign) NSUInteger routeCount;
+@property (nonatomic, assign) NSUInteger operations;
+@property (nonatomic, assign) double nanosecondsPerOperation;
+@property (nonatomic, assign) double allocationsPerOperation;
+@property (nonatomic, assign) unsigned long long p50;
+@property (nonatomic, assign) unsigned long long p90;
+@property (nonatomic, assign) unsigned long long p99;
+@property (nonatomic, assign) double timeShare;
+@property (nonatomic, assign) NSUInteger mismatches;
+
+- (void)printWithFormat:(JLRBenchmarkFormat)format;
+
+@end
+
+
+@implementation JLRBenchmarkReplayResult
+
++ (void)printHeaderWithFormat:(JLRBenchmarkFormat)format
+{
+    if (format == JLRBenchmarkFormatCSV) {
+        printf("case,table,pattern,routes,operations,ops_per_sec,ns_per_op,allocs_per_op,p50_ns,p90_ns,p99_ns,time_share,mismatches\n");
+    }
+}
+
+- (void)printWithFormat:(JLRBenchmarkFormat)format
+{
+    double allocationsPerOperation = JLRBENCHMARK_COUNTS_ALLOCATIONS ? self.allocationsPerOperation : -1;
+    double operationsPerSecond = (self.nanosecondsPerOperation > 0) ? 1e9 / self.nanosecondsPerOperation : 0;
+    
+    if (format == JLRBenchmarkFormatCSV) {
+        printf("%s,%s,%s,%lu,%lu,%.0f,%.1f,%.2f,%llu,%llu,%llu,%.4f,%lu\n", self.benchmarkCase.UTF8String, [self _CSVField:self.table].UTF8String, [self _CSVField:self.pattern].UTF8String, (unsigned long)self.routeCount, (unsigned long)self.operations, operationsPerSecond, self.nanosecondsPerOperation, allocationsPerOperation, self.p50, self.p90, self.p99, self.timeShare, (unsigned long)self.mismatches);
+    } else {
+        printf("{\"case\":\"%s\",\"table\":%s,\"pattern\":%s,\"routes\":%lu,\"operations\":%lu,\"ops_per_sec\":%.0f,\"ns_per_op\":%.1f,\"allocs_per_op\":%.2f,\"p50_ns\":%llu,\"p90_ns\":%llu,\"p99_ns\":%llu,\"time_share\":%.4f,\"mismatches\":%lu}\n", self.benchmarkCase.UTF8String, [self _JSONString:self.table].UTF8String, [self _JSONString:self.pattern].UTF8String, (unsigned long)self.routeCount, (unsigned long)self.operations, operationsPerSecond, self.nanosecondsPerOperation, allocationsPerOperation, self.p50, self.p90, self.p99, self.timeShare, (unsigned long)self.mismatches);
+    }
+    
+    fflush(stdout);
+}
+
+// patterns and paths come from outside the benchmark, so unlike the other output they are quoted where needed
+- (NSString *)_CSVField:(NSString *)field
+{
+    if (field == nil) {
+        return @"";
+    }
+    if ([field rangeOfCharacterFromSet:[NSCharacterSet characterSetWithCharactersInString:@",\"\n"]].location == NSNotFound) {
+        return field;
+    }
+    return [NSString stringWithFormat:@"\"%@\"", [field stringByReplacingOccurrencesOfString:@"\"" withString:@"\"\""]];
+}
+
+- (NSString *)_JSONString:(NSString *)string
+{
+    if (string == nil) {
+        return @"null";
+    }
+    NSString *escaped = [[string stringByReplacingOccurrencesOfString:@"\\" withString:@"\\\\"] stringByReplacingOccurrencesOfString:@"\"" withString:@"\\\""];
+    return [NSString stringWithFormat:@"\"%@\"", escaped];
+}
+
+@end
+
+
+#pragma mark - Benchmarks
+
+@interface JLRBenchmark : NSObject
+
+@property (nonatomic, strong) JLRBenchmarkConfiguration *configuration;
+
+- (void)run;
+
+@end
+
+
+@implementation JLRBenchmark
+
+- (void)run
+{
+    JLRBenchmarkConfiguration *configuration = self.configuration;
+    
+    if (configuration.replayTracePath != nil) {
+        [self _replayTrace];
+        return;
+    }
+    
+    [JLRBenchmarkResult printHeaderWithFormat:configuration.format];
+    
+    for (NSString *benchmarkCase in configuration.cases) {
+        for (NSString *shape in configuration.shapes) {
+            if ([benchmarkCase isEqualToString:@"expandOptional"]) {
+                // only depends on the pattern, not on what else is registered
+                [[self _benchmarkExpandOptionalForShape:shape] printWithFormat:configuration.format];
+                continue;
+            }
+            
+            for (NSNumber *routeCount in configuration.routeCounts) {
+                if ([benchmarkCase isEqualToString:@"register"]) {
+                    [[self _benchmarkRegisterForShape:shape routeCount:routeCount.unsignedIntegerValue] printWithFormat:configuration.format];
+                    continue;
+                }
+                
+                for (NSNumber *hitRatio in configuration.hitRatios) {
+                    JLRBenchmarkResult *result = [self _benchmarkRoutingCase:benchmarkCase shape:shape routeCount:routeCount.unsignedIntegerValue hitRatio:hitRatio.doubleValue];
+                    [result printWithFormat:configuration.format];
+                }
+            }
+        }
+    }
+}
+
+#pragma mark - Cases
+
+- (JLRBenchmarkResult *)_benchmarkRoutingCase:(NSString *)benchmarkCase shape:(NSString *)shape routeCount:(NSUInteger)routeCount hitRatio:(double)hitRatio
+{
+    NSUInteger operations = self.configuration.operations;
+    JLRoutes *routes = [JLRoutes routesForScheme:@"bench"];
+    
+    for (NSUInteger index = 0; index < routeCount; index++) {
+        [routes addRoute:[self _patternForShape:shape index:index] handler:^BOOL(NSDictionary *parameters) {
+            return YES;
+        }];
+    }
+    
+    // build every URL up front, so that only JLRoutes is measured
+    NSMutableArray <NSURL *> *URLs = [NSMutableArray arrayWithCapacity:operations];
+    unsigned long long state = 0x9E3779B97F4A7C15ULL;
+    for (NSUInteger index = 0; index < operations; index++) {
+        NSUInteger routeIndex = (NSUInteger)(JLRBenchmarkRandom(&state) % routeCount);
+        BOOL hit = (double)(JLRBenchmarkRandom(&state) % 10000) < hitRatio * 10000;
+        [URLs addObject:[self _URLForShape:shape index:routeIndex hit:hit]];
+    }
+    
+    JLRRouteRequestOptions options = JLRRouteRequestOptionDecodePlusSymbols;
+    JLRBenchmarkResult *result = [self _measureOperations:operations usingBlock:^(NSUInteger index) {
+        if ([benchmarkCase isEqualToString:@"routeURL"]) {
+            [routes routeURL:URLs[index]];
+        } else if ([benchmarkCase isEqualToString:@"canRouteURL"]) {
+            [routes canRouteURL:URLs[index]];
+        } else {
+            JLRRouteRequest *request = [[JLRRouteRequest alloc] initWithURL:URLs[index] options:options additionalParameters:nil];
+            (void)request.pathComponents;
+            (void)request.queryParams;
+        }
+    }];
+    
+    [JLRoutes unregisterRouteScheme:@"bench"];
+    
+    result.benchmarkCase = benchmarkCase;
+    result.shape = shape;
+    result.routeCount = routeCount;
+    result.hitRatio = hitRatio;
+    
+    return result;
+}
+
+- (JLRBenchmarkResult *)_benchmarkExpandOptionalForShape:(NSString *)shape
+{
+    NSString *pattern = [self _patternForShape:shape index:0];
+    
+    JLRBenchmarkResult *result = [self _measureOperations:self.configuration.operations usingBlock:^(NSUInteger index) {
+        [JLRParsingUtilities expandOptionalRoutePatternsForPattern:pattern];
+    }];
+    
+    result.benchmarkCase = @"expandOptional";
+    result.shape = shape;
+    
+    return result;
+}
+
+- (JLRBenchmarkResult *)_benchmarkRegisterForShape:(NSString *)shape routeCount:(NSUInteger)routeCount
+{
+    NSMutableArray <NSString *> *patterns = [NSMutableArray arrayWithCapacity:routeCount];
+    for (NSUInteger index = 0; index < routeCount; index++) {
+        [patterns addObject:[self _patternForShape:shape index:index]];
+    }
+    
+    JLRoutes *routes = [JLRoutes routesForScheme:@"bench"];
+    BOOL (^handlerBlock)(NSDictionary *) = ^BOOL(NSDictionary *parameters) {
+        return YES;
+    };
+    
+    JLRBenchmarkResult *result = [self _measureOperations:routeCount usingBlock:^(NSUInteger index) {
+        [routes addRoute:patterns[index] handler:handlerBlock];
+    }];
+    
+    // the first route attempt after registering pays for indexing the routes, so it counts towards registration
+    unsigned long long start = JLRBenchmarkNow();
+    [routes canRouteURL:[NSURL URLWithString:@"bench://warm"]];
+    result.nanosecondsPerOperation += (double)(JLRBenchmarkNow() - start) / (double)routeCount;
+    
+    [JLRoutes unregisterRouteScheme:@"bench"];
+    
+    result.benchmarkCase = @"register";
+    result.shape = shape;
+    result.routeCount = routeCount;
+    
+    return result;
+}
+
+#pragma mark - Measuring
+
+- (JLRBenchmarkResult *)_measureOperations:(NSUInteger)operations usingBlock:(void (^)(NSUInteger index))block
+{
+    unsigned long long *samples = calloc(operations, sizeof(unsigned long long));
+    unsigned long long totalTime = 0;
+    unsigned long long allocations = JLRBenchmarkAllocationCount();
+    
+    @autoreleasepool {
+        for (NSUInteger index = 0; index < operations; index++) {
+            unsigned long long start = JLRBenchmarkNow();
+            block(index);
+            samples[index] = JLRBenchmarkNow() - start;
+            totalTime += samples[index];
+        }
+    }
+    
+    allocations = JLRBenchmarkAllocationCount() - allocations;
+    qsort(samples, operations, sizeof(unsigned long long), JLRBenchmarkCompareSamples);
+    
+    JLRBenchmarkResult *result = [[JLRBenchmarkResult alloc] init];
+    result.operations = operations;
+    result.nanosecondsPerOperation = (double)totalTime / (double)operations;
+    result.allocationsPerOperation = (double)allocations / (double)operations;
+    result.p50 = samples[operations * 50 / 100];
+    result.p90 = samples[operations * 90 / 100];
+    result.p99 = samples[operations * 99 / 100];
+    
+    free(samples);
+    
+    return result;
+}
+
+#pragma mark - Replaying
+
+// Stubbed handlers decline as many times as the recorded handlers did, so the same routes are tried, and then note which route took the URL.
+static NSUInteger JLRBenchmarkReplay_remainingDeclines = 0;
+static __unsafe_unretained NSString *JLRBenchmarkReplay_handlingPattern = nil;
+
+- (void)_replayTrace
+{
+    JLRBenchmarkConfiguration *configuration = self.configuration;
+    NSError *error = nil;
+    NSArray <JLRRouteRecord *> *records = [JLRRouteRecord recordsWithContentsOfURL:[NSURL fileURLWithPath:configuration.replayTracePath] error:&error];
+    
+    if (records.count == 0) {
+        fprintf(stderr, "no records to replay in %s %s\n", configuration.replayTracePath.UTF8String, (error.localizedDescription ?: @"").UTF8String);
+        exit(1);
+    }
+    
+    // only the keys of additional parameters are recorded, so placeholder values stand in for the real ones
+    NSMutableArray *parameters = [NSMutableArray arrayWithCapacity:records.count];
+    for (JLRRouteRecord *record in records) {
+        NSMutableDictionary *recordParameters = [NSMutableDictionary dictionary];
+        for (NSString *key in record.parameterKeys) {
+            recordParameters[key] = @"";
+        }
+        [parameters addObject:(recordParameters.count > 0) ? recordParameters : [NSNull null]];
+    }
+    
+    [JLRBenchmarkReplayResult printHeaderWithFormat:configuration.format];
+    
+    for (NSString *tablePath in configuration.routeTablePaths) {
+        @autoreleasepool {
+            NSUInteger routeCount = [self _loadRouteTablesAtPath:tablePath];
+            [self _replayRecords:records parameters:parameters table:tablePath routeCount:routeCount];
+            [JLRoutes unregisterAllRouteSchemes];
+        }
+    }
+}
+
+- (NSUInteger)_loadRouteTablesAtPath:(NSString *)path
+{
+    NSMutableDictionary <NSString *, NSString *> *tablePathsByScheme = [NSMutableDictionary dictionary];
+    BOOL isDirectory = NO;
+    
+    if (![[NSFileManager defaultManager] fileExistsAtPath:path isDirectory:&isDirectory]) {
+        fprintf(stderr, "no route table at %s\n", path.UTF8String);
+        exit(1);
+    }
+    
+    if (isDirectory) {
+        for (NSString *fileName in [[NSFileManager defaultManager] contentsOfDirectoryAtPath:path error:NULL]) {
+            if ([fileName.pathExtension isEqualToString:@"table"]) {
+                tablePathsByScheme[fileName.stringByDeletingPathExtension] = [path stringByAppendingPathComponent:fileName];
+            }
+        }
+    } else {
+        tablePathsByScheme[JLRoutesGlobalRoutesScheme] = path;
+    }
+    
+    BOOL (^ (^handlerProvider)(NSString *))(NSDictionary *) = ^BOOL (^(NSString *pattern))(NSDictionary *) {
+        return ^BOOL(NSDictionary *handlerParameters) {
+            if (JLRBenchmarkReplay_remainingDeclines > 0) {
+                JLRBenchmarkReplay_remainingDeclines--;
+                return NO;
+            }
+            JLRBenchmarkReplay_handlingPattern = pattern;
+            return YES;
+        };
+    };
+    
+    NSUInteger routeCount = 0;
+    
+    for (NSString *scheme in tablePathsByScheme) {
+        JLRoutes *routes = [JLRoutes routesForScheme:scheme];
+        NSError *error = nil;
+        
+        if (![routes loadRouteTableFromURL:[NSURL fileURLWithPath:tablePathsByScheme[scheme]] fingerprint:self.configuration.fingerprint handlerProvider:handlerProvider error:&error]) {
+            fprintf(stderr, "can't load route table %s: %s\n", tablePathsByScheme[scheme].UTF8String, error.localizedDescription.UTF8String);
+            exit(1);
+        }
+        
+        routeCount += routes.routes.count;
+    }
+    
+    return routeCount;
+}
+
+- (void)_replayRecords:(NSArray <JLRRouteRecord *> *)records parameters:(NSArray *)parameters table:(NSString *)table routeCount:(NSUInteger)routeCount
+{
+    NSUInteger operations = records.count;
+    unsigned long long *samples = calloc(operations, sizeof(unsigned long long));
+    NSMutableArray *handlingPatterns = [NSMutableArray arrayWithCapacity:operations];
+    NSUInteger mismatches = 0;
+    
+    // the first pass isn't measured: it builds the route indexes and caches, which a running app would already have
+    for (NSUInteger pass = 0; pass < 2; pass++) {
+        BOOL measures = (pass == 1);
+        unsigned long long allocations = JLRBenchmarkAllocationCount();
+        unsigned long long totalTime = 0;
+        
+        @autoreleasepool {
+            for (NSUInteger index = 0; index < operations; index++) {
+                JLRRouteRecord *record = records[index];
+                NSDictionary *recordParameters = (parameters[index] != [NSNull null]) ? parameters[index] : nil;
+                JLRBenchmarkReplay_remainingDeclines = record.declinedHandlerCount;
+                JLRBenchmarkReplay_handlingPattern = nil;
+                
+                unsigned long long start = JLRBenchmarkNow();
+                BOOL didRoute = [JLRoutes routeURL:record.URL withParameters:recordParameters];
+                unsigned long long sample = JLRBenchmarkNow() - start;
+                
+                if (measures) {
+                    samples[index] = sample;
+                    totalTime += sample;
+                    [handlingPatterns addObject:JLRBenchmarkReplay_handlingPattern ?: [NSNull null]];
+                    mismatches += (didRoute != record.didRoute) ? 1 : 0;
+                }
+            }
+        }
+        
+        if (!measures) {
+            continue;
+        }
+        
+        allocations = JLRBenchmarkAllocationCount() - allocations;
+        
+        JLRBenchmarkReplayResult *result = [self _replayResultWithSamples:samples indexes:nil count:operations totalTime:totalTime];
+        result.benchmarkCase = @"replay";
+        result.table = table;
+        result.routeCount = routeCount;
+        result.allocationsPerOperation = (double)allocations / (double)operations;
+        result.timeShare = 1;
+        result.mismatches = mismatches;
+        [result printWithFormat:self.configuration.format];
+        
+        [self _printRouteCostsForSamples:samples handlingPatterns:handlingPatterns table:table routeCount:routeCount totalTime:totalTime];
+    }
+    
+    free(samples);
+}
+
+- (void)_printRouteCostsForSamples:(const unsigned long long *)samples handlingPatterns:(NSArray *)handlingPatterns table:(NSString *)table routeCount:(NSUInteger)routeCount totalTime:(unsigned long long)totalTime
+{
+    // URLs that no route took (including ones every handler declined) are grouped under a null pattern
+    NSMutableDictionary <id, NSMutableIndexSet *> *indexesByPattern = [NSMutableDictionary dictionary];
+    [handlingPatterns enumerateObjectsUsingBlock:^(id pattern, NSUInteger index, BOOL *stop) {
+        NSMutableIndexSet *indexes = indexesByPattern[pattern];
+        if (indexes == nil) {
+            indexes = [NSMutableIndexSet indexSet];
+            indexesByPattern[pattern] = indexes;
+        }
+        [indexes addIndex:index];
+    }];
+    
+    NSMutableArray <JLRBenchmarkReplayResult *> *results = [NSMutableArray array];
+    
+    for (id pattern in indexesByPattern) {
+        NSIndexSet *indexes = indexesByPattern[pattern];
+        unsigned long long routeTime = 0;
+        for (NSUInteger index = indexes.firstIndex; index != NSNotFound; index = [indexes indexGreaterThanIndex:index]) {
+            routeTime += samples[index];
+        }
+        
+        JLRBenchmarkReplayResult *result = [self _replayResultWithSamples:samples indexes:indexes count:indexes.count totalTime:routeTime];
+        result.benchmarkCase = @"replayRoute";
+        result.table = table;
+        result.pattern = (pattern != [NSNull null]) ? pattern : nil;
+        result.routeCount = routeCount;
+        result.allocationsPerOperation = -1;
+        result.timeShare = (totalTime > 0) ? (double)routeTime / (double)totalTime : 0;
+        [results addObject:result];
+    }
+    
+    // the routes that cost the most overall come first
+    [results sortUsingComparator:^NSComparisonResult(JLRBenchmarkReplayResult *first, JLRBenchmarkReplayResult *second) {
+        return [@(second.timeShare) compare:@(first.timeShare)];
+    }];
+    
+    for (JLRBenchmarkReplayResult *result in results) {
+        [result printWithFormat:self.configuration.format];
+    }
+}
+
+// Summarizes the samples at indexes (or all count of them, if indexes is nil).
+- (JLRBenchmarkReplayResult *)_replayResultWithSamples:(const unsigned long long *)samples indexes:(NSIndexSet *)indexes count:(NSUInteger)count totalTime:(unsigned long long)totalTime
+{
+    unsigned long long *sortedSamples = calloc(count, sizeof(unsigned long long));
+    
+    if (indexes == nil) {
+        memcpy(sortedSamples, samples, count * sizeof(unsigned long long));
+    } else {
+        NSUInteger sampleIndex = 0;
+        for (NSUInteger index = indexes.firstIndex; index != NSNotFound; index = [indexes indexGreaterThanIndex:index]) {
+            sortedSamples[sampleIndex++] = samples[index];
+        }
+    }
+    
+    qsort(sortedSamples, count, sizeof(unsigned long long), JLRBenchmarkCompareSamples);
+    
+    JLRBenchmarkReplayResult *result = [[JLRBenchmarkReplayResult alloc] init];
+    result.operations = count;
+    result.nanosecondsPerOperation = (double)totalTime / (double)count;
+    result.p50 = sortedSamples[count * 50 / 100];
+    result.p90 = sortedSamples[count * 90 / 100];
+    result.p99 = sortedSamples[count * 99 / 100];
+    
+    free(sortedSamples);
+    
+    return result;
+}
+
+#pragma mark - Patterns and URLs
+
+- (NSString *)_patternForShape:(NSString *)shape index:(NSUInteger)index
+{
+    unsigned long value = (unsigned long)index;
+    
+    if ([shape isEqualToString:@"variable"]) {
+        return [NSString stringWithFormat:@"/v%lu/:first/:second/:third", value];
+    } else if ([shape isEqualToString:@"wildcard"]) {
+        return [NSString stringWithFormat:@"/w%lu/items/*", value];
+    } else if ([shape isEqualToString:@"optional"]) {
+        return [NSString stringWithFormat:@"/o%lu/:first(/:second)(/:third)", value];
+    } else {
+        return [NSString stringWithFormat:@"/s%lu/items/list", value];
+    }
+}
+
+- (NSURL *)_URLForShape:(NSString *)shape index:(NSUInteger)index hit:(BOOL)hit
+{
+    unsigned long value = (unsigned long)index;
+    NSString *path = nil;
+    
+    if ([shape isEqualToString:@"variable"]) {
+        path = [NSString stringWithFormat:@"v%lu/a/b+c/d", value];
+    } else if ([shape isEqualToString:@"wildcard"]) {
+        path = [NSString stringWithFormat:@"w%lu/items/a/b/c", value];
+    } else if ([shape isEqualToString:@"optional"]) {
+        path = [NSString stringWithFormat:@"o%lu/a/b", value];
+    } else {
+        path = [NSString stringWithFormat:@"s%lu/items/list", value];
+    }
+    
+    // misses share every component with a registered route but the first, which is usually the worst case
+    NSString *URLString = [NSString stringWithFormat:@"bench://%@%@?source=benchmark&id=%lu", (hit ? @"" : @"miss-"), path, value];
+    return [NSURL URLWithString:URLString];
+}
+
+@end
+
+
+int main(int argc, const char *argv[])
+{
+    @autoreleasepool {
+        NSMutableArray <NSString *> *arguments = [NSMutableArray array];
+        for (int index = 0; index < argc; index++) {
+            [arguments addObject:[NSString stringWithUTF8String:argv[index]]];
+        }
+        
+        JLRBenchmark *benchmark = [[JLRBenchmark alloc] init];
+        benchmark.configuration = [JLRBenchmarkConfiguration configurationWithArguments:arguments];
+        [benchmark run];
+    }
+    return 0;
+}
@@ -0,0 +1,45 @@
+/*
+ Copyright (c) 2017, Joel Levin
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ 
+ Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ Neither the name of JLRoutes nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+
+@class JLRRouteRequest;
+
+
+/**
+ JLRMatchParameters is the dictionary of match parameters handed to a route's handler block.
+ 
+ Rather than merging every source of parameters into a new dictionary for each match, it looks keys up in each
+ source in order of precedence: the default parameters, then the request's additional parameters, then the route
+ variables, and finally the request's query params. Query param values are decoded by the request on first access.
+ */
+
+@interface JLRMatchParameters : NSDictionary
+
+/**
+ Creates a new set of match parameters.
+ 
+ @param request The request that was matched.
+ @param routeVariables The route variables parsed from the request.
+ @param defaultParameters The default match parameters, which take precedence over every other source.
+ 
+ @returns The newly initialized match parameters.
+ */
+- (instancetype)initWithRequest:(JLRRouteRequest *)request routeVariables:(NSDictionary *)routeVariables defaultParameters:(NSDictionary *)defaultParameters;
+
+@end
+
+
+NS_ASSUME_NONNULL_END
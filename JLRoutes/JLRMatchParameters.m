@@ -0,0 +1,104 @@
+/*
+ Copyright (c) 2017, Joel Levin
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ 
+ Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ Neither the name of JLRoutes nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import "JLRMatchParameters.h"
+#import "JLRRouteRequest.h"
+
+
+@implementation JLRMatchParameters
+{
+    JLRRouteRequest *_request;
+    NSDictionary *_queryParams;
+    NSArray <NSDictionary *> *_layers;
+    NSSet *_allKeys;
+}
+
+- (instancetype)initWithRequest:(JLRRouteRequest *)request routeVariables:(NSDictionary *)routeVariables defaultParameters:(NSDictionary *)defaultParameters
+{
+    if ((self = [super init])) {
+        _request = request;
+        
+        // parse the query params now, on the routing thread, rather than whenever the handler first reads one
+        _queryParams = request.queryParams;
+        
+        if (request.additionalParameters != nil) {
+            _layers = @[defaultParameters, request.additionalParameters, routeVariables];
+        } else {
+            _layers = @[defaultParameters, routeVariables];
+        }
+    }
+    return self;
+}
+
+- (instancetype)initWithObjects:(const id _Nonnull [_Nullable])objects forKeys:(const id <NSCopying> _Nonnull [_Nullable])keys count:(NSUInteger)count
+{
+    if ((self = [super init])) {
+        _layers = @[[[NSDictionary alloc] initWithObjects:objects forKeys:keys count:count]];
+    }
+    return self;
+}
+
+#pragma mark - NSDictionary
+
+- (NSUInteger)count
+{
+    return [self _allKeys].count;
+}
+
+- (nullable id)objectForKey:(id)key
+{
+    for (NSDictionary *layer in _layers) {
+        id value = layer[key];
+        if (value != nil) {
+            return value;
+        }
+    }
+    
+    if (_queryParams[key] == nil) {
+        return nil;
+    }
+    
+    return [_request queryParamValueForKey:key];
+}
+
+- (NSEnumerator *)keyEnumerator
+{
+    return [[self _allKeys] objectEnumerator];
+}
+
+- (id)copyWithZone:(NSZone *)zone
+{
+    // immutable, and so are all of the layers
+    return self;
+}
+
+#pragma mark - Private
+
+- (NSSet *)_allKeys
+{
+    @synchronized (self) {
+        if (_allKeys == nil) {
+            NSMutableSet *allKeys = [NSMutableSet setWithCapacity:_queryParams.count];
+            
+            [allKeys addObjectsFromArray:_queryParams.allKeys];
+            for (NSDictionary *layer in _layers) {
+                [allKeys addObjectsFromArray:layer.allKeys];
+            }
+            
+            _allKeys = [allKeys copy];
+        }
+        
+        return _allKeys;
+    }
+}
+
+@end
@@ -15,14 +15,41 @@
 NS_ASSUME_NONNULL_BEGIN
 
 
+/// A run of route pattern path components that are either all required, or together make up one optional '( … )' group.
+@interface JLRParsingUtilities_RouteSubpath : NSObject
+
+@property (nonatomic, strong) NSArray <NSString *> *subpathComponents;
+@property (nonatomic, assign) BOOL isOptionalSubpath;
+
+@end
+
+
 @interface JLRParsingUtilities : NSObject
 
-+ (NSString *)variableValueFrom:(NSString *)value decodePlusSymbols:(BOOL)decodePlusSymbols;
++ (nullable NSString *)variableValueFrom:(nullable NSString *)value decodePlusSymbols:(BOOL)decodePlusSymbols;
+
+/**
+ Removes percent encoding from and/or decodes plus symbols in UTF-8 bytes, in a single pass. A '+' that comes from
+ decoding '%2B' is also turned into a space, just as if the percent encoding were removed before decoding plus symbols.
+ 
+ @returns The decoded string, or nil if the bytes contain an invalid percent escape or don't decode to valid UTF-8.
+ */
++ (nullable NSString *)stringByDecodingUTF8Bytes:(const char *)bytes length:(NSUInteger)length removePercentEncoding:(BOOL)removePercentEncoding decodePlusSymbols:(BOOL)decodePlusSymbols;
+
+/// Decodes string like +stringByDecodingUTF8Bytes:length:removePercentEncoding:decodePlusSymbols:, returning string itself if there is nothing to decode.
++ (nullable NSString *)stringByDecodingString:(NSString *)string removePercentEncoding:(BOOL)removePercentEncoding decodePlusSymbols:(BOOL)decodePlusSymbols;
+
++ (id)queryParamValue:(id)value decodePlusSymbols:(BOOL)decodePlusSymbols;
 
 + (NSDictionary *)queryParams:(NSDictionary *)queryParams decodePlusSymbols:(BOOL)decodePlusSymbols;
 
 + (NSArray <NSString *> *)expandOptionalRoutePatternsForPattern:(NSString *)routePattern;
 
++ (NSArray <JLRParsingUtilities_RouteSubpath *> *)routeSubpathsForPattern:(NSString *)routePattern;
+
+/// Splits a ':variable<constraint>' pattern path component into ':variable' and the text between '<' and '>', which is nil if there is no constraint.
++ (NSString *)patternComponentByRemovingVariableConstraint:(NSString *)patternComponent constraint:(NSString * _Nullable * _Nullable)constraint;
+
 @end
 
 
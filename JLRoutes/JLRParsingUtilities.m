@@ -29,15 +29,60 @@
 @end
 
 
-#pragma mark - Parsing Utility Methods
+#pragma mark - Decoding
+
 
+// Returns the number of bytes before the first one that needs decoding. Eight bytes are checked at a time, using the
+// "has zero byte" trick on the word XORed with the byte being searched for, so long runs of plain text are skipped quickly.
+static NSUInteger JLRParsingUtilitiesLengthOfPlainRun(const char *bytes, NSUInteger length, BOOL removePercentEncoding, BOOL decodePlusSymbols)
+{
+    static const uint64_t lowBits = 0x0101010101010101ULL;
+    static const uint64_t highBits = 0x8080808080808080ULL;
+    NSUInteger index = 0;
+    
+    for (; index + sizeof(uint64_t) <= length; index += sizeof(uint64_t)) {
+        uint64_t word = 0;
+        memcpy(&word, bytes + index, sizeof(uint64_t));
+        
+        uint64_t found = 0;
+        if (removePercentEncoding) {
+            uint64_t percents = word ^ (lowBits * '%');
+            found |= (percents - lowBits) & ~percents & highBits;
+        }
+        if (decodePlusSymbols) {
+            uint64_t pluses = word ^ (lowBits * '+');
+            found |= (pluses - lowBits) & ~pluses & highBits;
+        }
+        
+        if (found != 0) {
+            // the exact byte is found below
+            break;
+        }
+    }
+    
+    for (; index < length; index++) {
+        if ((removePercentEncoding && bytes[index] == '%') || (decodePlusSymbols && bytes[index] == '+')) {
+            break;
+        }
+    }
+    
+    return index;
+}
 
-@interface JLRParsingUtilities_RouteSubpath : NSObject
+static int JLRParsingUtilitiesHexDigitValue(char character)
+{
+    if (character >= '0' && character <= '9') {
+        return character - '0';
+    } else if (character >= 'a' && character <= 'f') {
+        return character - 'a' + 10;
+    } else if (character >= 'A' && character <= 'F') {
+        return character - 'A' + 10;
+    }
+    return -1;
+}
 
-@property (nonatomic, strong) NSArray <NSString *> *subpathComponents;
-@property (nonatomic, assign) BOOL isOptionalSubpath;
 
-@end
+#pragma mark - Parsing Utility Methods
 
 
 @implementation JLRParsingUtilities_RouteSubpath
@@ -77,11 +122,96 @@
 @implementation JLRParsingUtilities
 
 + (NSString *)variableValueFrom:(NSString *)value decodePlusSymbols:(BOOL)decodePlusSymbols
+{
+    if (!decodePlusSymbols || value == nil) {
+        return value;
+    }
+    return [self stringByDecodingString:value removePercentEncoding:NO decodePlusSymbols:YES];
+}
+
++ (NSString *)stringByDecodingUTF8Bytes:(const char *)bytes length:(NSUInteger)length removePercentEncoding:(BOOL)removePercentEncoding decodePlusSymbols:(BOOL)decodePlusSymbols
+{
+    NSUInteger plainLength = JLRParsingUtilitiesLengthOfPlainRun(bytes, length, removePercentEncoding, decodePlusSymbols);
+    
+    if (plainLength == length) {
+        return [[NSString alloc] initWithBytes:bytes length:length encoding:NSUTF8StringEncoding];
+    }
+    
+    // decoding never makes the string longer
+    char stackBuffer[256];
+    char *decoded = length <= sizeof(stackBuffer) ? stackBuffer : malloc(length);
+    NSUInteger decodedLength = 0;
+    NSUInteger index = 0;
+    BOOL isValid = YES;
+    
+    while (index < length) {
+        // copy everything up to the next byte that needs decoding
+        memcpy(decoded + decodedLength, bytes + index, plainLength);
+        decodedLength += plainLength;
+        index += plainLength;
+        
+        if (index == length) {
+            break;
+        }
+        
+        char character = bytes[index];
+        if (character == '%') {
+            int high = index + 2 < length ? JLRParsingUtilitiesHexDigitValue(bytes[index + 1]) : -1;
+            int low = high >= 0 ? JLRParsingUtilitiesHexDigitValue(bytes[index + 2]) : -1;
+            if (low < 0) {
+                isValid = NO;
+                break;
+            }
+            
+            character = (char)((high << 4) | low);
+            index += 3;
+        } else {
+            index++;
+        }
+        
+        decoded[decodedLength++] = (decodePlusSymbols && character == '+') ? ' ' : character;
+        plainLength = JLRParsingUtilitiesLengthOfPlainRun(bytes + index, length - index, removePercentEncoding, decodePlusSymbols);
+    }
+    
+    NSString *string = isValid ? [[NSString alloc] initWithBytes:decoded length:decodedLength encoding:NSUTF8StringEncoding] : nil;
+    
+    if (decoded != stackBuffer) {
+        free(decoded);
+    }
+    
+    return string;
+}
+
++ (NSString *)stringByDecodingString:(NSString *)string removePercentEncoding:(BOOL)removePercentEncoding decodePlusSymbols:(BOOL)decodePlusSymbols
+{
+    const char *bytes = string.UTF8String ?: "";
+    NSUInteger length = strlen(bytes);
+    
+    if (JLRParsingUtilitiesLengthOfPlainRun(bytes, length, removePercentEncoding, decodePlusSymbols) == length) {
+        return string;
+    }
+    
+    return [self stringByDecodingUTF8Bytes:bytes length:length removePercentEncoding:removePercentEncoding decodePlusSymbols:decodePlusSymbols];
+}
+
++ (id)queryParamValue:(id)value decodePlusSymbols:(BOOL)decodePlusSymbols
 {
     if (!decodePlusSymbols) {
         return value;
     }
-    return [value stringByReplacingOccurrencesOfString:@"+" withString:@" " options:NSLiteralSearch range:NSMakeRange(0, value.length)];
+    
+    if ([value isKindOfClass:[NSArray class]]) {
+        NSMutableArray *variables = [NSMutableArray array];
+        for (NSString *arrayValue in (NSArray *)value) {
+            [variables addObject:[self variableValueFrom:arrayValue decodePlusSymbols:YES]];
+        }
+        return [variables copy];
+    } else if ([value isKindOfClass:[NSString class]]) {
+        return [self variableValueFrom:value decodePlusSymbols:YES];
+    } else {
+        NSAssert(NO, @"Unexpected query parameter type: %@", NSStringFromClass([value class]));
+        return value;
+    }
 }
 
 + (NSDictionary *)queryParams:(NSDictionary *)queryParams decodePlusSymbols:(BOOL)decodePlusSymbols
@@ -93,20 +223,7 @@
     NSMutableDictionary *updatedQueryParams = [NSMutableDictionary dictionary];
     
     for (NSString *name in queryParams) {
-        id value = queryParams[name];
-        
-        if ([value isKindOfClass:[NSArray class]]) {
-            NSMutableArray *variables = [NSMutableArray array];
-            for (NSString *arrayValue in (NSArray *)value) {
-                [variables addObject:[self variableValueFrom:arrayValue decodePlusSymbols:YES]];
-            }
-            updatedQueryParams[name] = [variables copy];
-        } else if ([value isKindOfClass:[NSString class]]) {
-            NSString *variable = [self variableValueFrom:value decodePlusSymbols:YES];
-            updatedQueryParams[name] = variable;
-        } else {
-            NSAssert(NO, @"Unexpected query parameter type: %@", NSStringFromClass([value class]));
-        }
+        updatedQueryParams[name] = [self queryParamValue:queryParams[name] decodePlusSymbols:YES];
     }
     
     return [updatedQueryParams copy];
@@ -135,7 +252,7 @@
     }
     
     // First, parse the route pattern into subpath objects.
-    NSArray <JLRParsingUtilities_RouteSubpath *> *subpaths = [self _routeSubpathsForPattern:routePattern];
+    NSArray <JLRParsingUtilities_RouteSubpath *> *subpaths = [self routeSubpathsForPattern:routePattern];
     if (subpaths.count == 0) {
         return @[];
     }
@@ -170,7 +287,7 @@
     return validSubpathRouteStrings;
 }
 
-+ (NSArray <JLRParsingUtilities_RouteSubpath *> *)_routeSubpathsForPattern:(NSString *)routePattern
++ (NSArray <JLRParsingUtilities_RouteSubpath *> *)routeSubpathsForPattern:(NSString *)routePattern
 {
     NSMutableArray <JLRParsingUtilities_RouteSubpath *> *subpaths = [NSMutableArray array];
     
@@ -215,6 +332,26 @@
     return [subpaths copy];
 }
 
++ (NSString *)patternComponentByRemovingVariableConstraint:(NSString *)patternComponent constraint:(NSString **)constraint
+{
+    NSRange constraintStart = [patternComponent rangeOfString:@"<"];
+    
+    if (constraint != NULL) {
+        *constraint = nil;
+    }
+    
+    // the name has to come before the constraint, as in ':id<int>'
+    if (![patternComponent hasPrefix:@":"] || ![patternComponent hasSuffix:@">"] || constraintStart.location == NSNotFound || constraintStart.location < 2) {
+        return patternComponent;
+    }
+    
+    if (constraint != NULL) {
+        *constraint = [patternComponent substringWithRange:NSMakeRange(NSMaxRange(constraintStart), patternComponent.length - NSMaxRange(constraintStart) - 1)];
+    }
+    
+    return [patternComponent substringToIndex:constraintStart.location];
+}
+
 @end
 
 
@@ -0,0 +1,87 @@
+/*
+ Copyright (c) 2017, Joel Levin
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ 
+ Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ Neither the name of JLRoutes nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import <Foundation/Foundation.h>
+
+@class JLRRouteDefinition;
+@class JLRRouteIndex;
+
+NS_ASSUME_NONNULL_BEGIN
+
+
+/**
+ JLRRouteResolution records which routes matched a set of path components, in the order they should be tried.
+ 
+ Routes whose matching depends only on their pattern are stored with the route variables they extracted. Routes
+ with custom matching logic are stored with NSNull, meaning they still need to be matched against each request.
+ */
+
+@interface JLRRouteResolution : NSObject
+
+/// The matching routes, in the order they should be tried.
+@property (nonatomic, copy, readonly) NSArray <JLRRouteDefinition *> *routes;
+
+/// For each of routes, either its route variables or NSNull.
+@property (nonatomic, copy, readonly) NSArray *routeVariables;
+
+/// Creates a new resolution. Both arrays must have the same count.
+- (instancetype)initWithRoutes:(NSArray <JLRRouteDefinition *> *)routes routeVariables:(NSArray *)routeVariables NS_DESIGNATED_INITIALIZER;
+
+/// Unavailable, use initWithRoutes:routeVariables: instead.
+- (instancetype)init NS_UNAVAILABLE;
+
+/// Unavailable, use initWithRoutes:routeVariables: instead.
++ (instancetype)new NS_UNAVAILABLE;
+
+@end
+
+
+/**
+ JLRResolutionCache is a thread safe, least recently used cache of route resolutions.
+ 
+ Resolutions are only valid for the route index they were computed from. Looking up or storing a resolution for
+ a different index than the cache currently holds empties the cache first, so mutating the routes invalidates it.
+ */
+
+@interface JLRResolutionCache : NSObject
+
+/// Creates a cache that holds at most limit resolutions.
+- (instancetype)initWithLimit:(NSUInteger)limit NS_DESIGNATED_INITIALIZER;
+
+/// Unavailable, use initWithLimit: instead.
+- (instancetype)init NS_UNAVAILABLE;
+
+/// Unavailable, use initWithLimit: instead.
++ (instancetype)new NS_UNAVAILABLE;
+
+/// The maximum number of resolutions held.
+@property (nonatomic, assign, readonly) NSUInteger limit;
+
+/// The number of lookups that found a resolution.
+@property (atomic, assign, readonly) NSUInteger hitCount;
+
+/// The number of lookups that did not find a resolution.
+@property (atomic, assign, readonly) NSUInteger missCount;
+
+/// Returns the resolution stored for key, if it was computed from routeIndex.
+- (nullable JLRRouteResolution *)resolutionForKey:(NSString *)key routeIndex:(JLRRouteIndex *)routeIndex;
+
+/// Stores resolution for key, evicting the least recently used resolution if the cache is full.
+- (void)setResolution:(JLRRouteResolution *)resolution forKey:(NSString *)key routeIndex:(JLRRouteIndex *)routeIndex;
+
+/// Removes every resolution. Does not reset hitCount or missCount.
+- (void)removeAllResolutions;
+
+@end
+
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,182 @@
+/*
+ Copyright (c) 2017, Joel Levin
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ 
+ Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ Neither the name of JLRoutes nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import "JLRResolutionCache.h"
+
+
+@implementation JLRRouteResolution
+
+- (instancetype)initWithRoutes:(NSArray <JLRRouteDefinition *> *)routes routeVariables:(NSArray *)routeVariables
+{
+    NSParameterAssert(routes.count == routeVariables.count);
+    
+    if ((self = [super init])) {
+        _routes = [routes copy];
+        _routeVariables = [routeVariables copy];
+    }
+    return self;
+}
+
+@end
+
+
+// A node in the cache's recency list, most recently used first.
+@interface JLRResolutionCacheNode : NSObject
+
+@property (nonatomic, copy) NSString *key;
+@property (nonatomic, strong) JLRRouteResolution *resolution;
+@property (nonatomic, strong, nullable) JLRResolutionCacheNode *next;
+@property (nonatomic, weak, nullable) JLRResolutionCacheNode *previous;
+
+@end
+
+
+@implementation JLRResolutionCacheNode
+
+@end
+
+
+@interface JLRResolutionCache ()
+
+@property (nonatomic, assign) NSUInteger limit;
+@property (atomic, assign) NSUInteger hitCount;
+@property (atomic, assign) NSUInteger missCount;
+
+@property (nonatomic, strong) NSMutableDictionary <NSString *, JLRResolutionCacheNode *> *nodes;
+@property (nonatomic, strong, nullable) JLRResolutionCacheNode *head;
+@property (nonatomic, weak, nullable) JLRResolutionCacheNode *tail;
+@property (nonatomic, strong, nullable) JLRRouteIndex *routeIndex;
+
+@end
+
+
+@implementation JLRResolutionCache
+
+- (instancetype)initWithLimit:(NSUInteger)limit
+{
+    if ((self = [super init])) {
+        self.limit = limit;
+        self.nodes = [NSMutableDictionary dictionaryWithCapacity:limit];
+    }
+    return self;
+}
+
+- (nullable JLRRouteResolution *)resolutionForKey:(NSString *)key routeIndex:(JLRRouteIndex *)routeIndex
+{
+    @synchronized (self) {
+        [self _validateForRouteIndex:routeIndex];
+        
+        JLRResolutionCacheNode *node = self.nodes[key];
+        
+        if (node == nil) {
+            self.missCount++;
+            return nil;
+        }
+        
+        self.hitCount++;
+        [self _moveNodeToHead:node];
+        
+        return node.resolution;
+    }
+}
+
+- (void)setResolution:(JLRRouteResolution *)resolution forKey:(NSString *)key routeIndex:(JLRRouteIndex *)routeIndex
+{
+    if (self.limit == 0) {
+        return;
+    }
+    
+    @synchronized (self) {
+        [self _validateForRouteIndex:routeIndex];
+        
+        JLRResolutionCacheNode *node = self.nodes[key];
+        
+        if (node == nil) {
+            node = [[JLRResolutionCacheNode alloc] init];
+            node.key = key;
+            self.nodes[key] = node;
+        }
+        
+        node.resolution = resolution;
+        [self _moveNodeToHead:node];
+        
+        if (self.nodes.count > self.limit) {
+            // evict the least recently used resolution
+            JLRResolutionCacheNode *tail = self.tail;
+            [self _unlinkNode:tail];
+            [self.nodes removeObjectForKey:tail.key];
+        }
+    }
+}
+
+- (void)removeAllResolutions
+{
+    @synchronized (self) {
+        [self.nodes removeAllObjects];
+        
+        // break the list apart one node at a time, rather than with one long chain of releases
+        while (self.head != nil) {
+            self.head = self.head.next;
+        }
+    }
+}
+
+#pragma mark - Private
+
+- (void)_validateForRouteIndex:(JLRRouteIndex *)routeIndex
+{
+    if (self.routeIndex != routeIndex) {
+        // the routes have changed since these resolutions were computed
+        [self removeAllResolutions];
+        self.routeIndex = routeIndex;
+    }
+}
+
+- (void)_moveNodeToHead:(JLRResolutionCacheNode *)node
+{
+    if (self.head == node) {
+        return;
+    }
+    
+    [self _unlinkNode:node];
+    
+    node.next = self.head;
+    self.head.previous = node;
+    self.head = node;
+    
+    if (self.tail == nil) {
+        self.tail = node;
+    }
+}
+
+- (void)_unlinkNode:(JLRResolutionCacheNode *)node
+{
+    JLRResolutionCacheNode *previous = node.previous;
+    JLRResolutionCacheNode *next = node.next;
+    
+    if (previous != nil) {
+        previous.next = next;
+    } else if (self.head == node) {
+        self.head = next;
+    }
+    
+    if (next != nil) {
+        next.previous = previous;
+    } else if (self.tail == node) {
+        self.tail = previous;
+    }
+    
+    node.previous = nil;
+    node.next = nil;
+}
+
+@end
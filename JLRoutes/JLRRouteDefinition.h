@@ -13,6 +13,8 @@
 #import <Foundation/Foundation.h>
 #import "JLRRouteRequest.h"
 #import "JLRRouteResponse.h"
+#import "JLRRouteMetrics.h"
+#import "JLRRouteMatchConstraints.h"
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -20,7 +22,16 @@ NS_ASSUME_NONNULL_BEGIN
 /**
  JLRRouteDefinition is a model object representing a registered route, including the URL scheme, route pattern, and priority.
  
- This class can be subclassed to customize route parsing behavior by overriding -routeResponseForRequest:.
+ Optional groups in the pattern ('/path/:thing(/new)(/other/:value)') are matched in place by a single definition. When more than
+ one combination of optional groups could match a URL, the one with the longest expanded pattern is used, and between equally long ones,
+ the one leaving out later groups. If the handler block returns NO, the other combinations aren't tried.
+ 
+ Variables can be constrained by writing the values they accept between '<' and '>' after their name: ':id<int>' (delivered as an
+ NSNumber), ':id<uuid>' (delivered as an NSUUID), ':code<2..8>' (a length range), or ':tab<home|feed>' (one of the listed strings).
+ A route doesn't match a URL whose path component its variable doesn't accept, so the next matching route is tried instead.
+ 
+ This class can be subclassed to customize route parsing behavior by overriding -routeResponseForRequest:, in which case
+ -matchConstraints can narrow down the requests it is asked about.
  -callHandlerBlockWithParameters can also be overriden to customize the parameters passed to the handlerBlock.
  */
 
@@ -35,12 +46,20 @@ NS_ASSUME_NONNULL_BEGIN
 /// The priority of this route pattern.
 @property (nonatomic, assign, readonly) NSUInteger priority;
 
-/// The route pattern path components.
+/// The route pattern path components. For patterns with optional '( … )' groups, these include the components of every group.
 @property (nonatomic, copy, readonly) NSArray <NSString *> *patternPathComponents;
 
+/// The number of pattern path components before the first optional group, which every match has in the same position.
+/// This is the count of patternPathComponents if the pattern has no optional groups.
+@property (nonatomic, assign, readonly) NSUInteger leadingRequiredPathComponentCount;
+
 /// The handler block to invoke when a match is found.
 @property (nonatomic, copy, readonly) BOOL (^handlerBlock)(NSDictionary *parameters);
 
+/// The asynchronous handler block to invoke when a match is found, if the route was created with one. It must call completion exactly once, on any thread,
+/// with YES if it handled the route or NO if the next matching route should be tried.
+@property (nonatomic, copy, readonly, nullable) void (^asyncHandlerBlock)(NSDictionary *parameters, void (^completion)(BOOL handled));
+
 /// Check for route definition equality.
 - (BOOL)isEqualToRouteDefinition:(JLRRouteDefinition *)routeDefinition;
 
@@ -61,7 +80,21 @@ NS_ASSUME_NONNULL_BEGIN
  
  @returns The newly initialized route definition.
  */
-- (instancetype)initWithPattern:(NSString *)pattern priority:(NSUInteger)priority handlerBlock:(BOOL (^)(NSDictionary *parameters))handlerBlock NS_DESIGNATED_INITIALIZER;
+- (instancetype)initWithPattern:(NSString *)pattern priority:(NSUInteger)priority handlerBlock:(nullable BOOL (^)(NSDictionary *parameters))handlerBlock NS_DESIGNATED_INITIALIZER;
+
+/**
+ Creates a new route definition with an asynchronous handler block.
+ 
+ Routing the definition with +[JLRoutes routeURL:withParameters:completion:] waits for the handler to call its completion block before
+ moving on. Routing synchronously with +[JLRoutes routeURL:] can't wait for it, so the handler isn't called and the next matching route is tried.
+ 
+ @param pattern The full route pattern ('/foo/:bar')
+ @param priority The route priority, or 0 if default.
+ @param asyncHandlerBlock The handler block to call when a successful match is found.
+ 
+ @returns The newly initialized route definition.
+ */
+- (instancetype)initWithPattern:(NSString *)pattern priority:(NSUInteger)priority asyncHandlerBlock:(void (^)(NSDictionary *parameters, void (^completion)(BOOL handled)))asyncHandlerBlock;
 
 /// Unavailable, use initWithScheme:pattern:priority:handlerBlock: instead.
 - (instancetype)init NS_UNAVAILABLE;
@@ -98,6 +131,19 @@ NS_ASSUME_NONNULL_BEGIN
 - (JLRRouteResponse *)routeResponseForRequest:(JLRRouteRequest *)request;
 
 
+/**
+ Describes which requests this route could possibly match, for subclasses that override -routeResponseForRequest: or
+ -routeVariablesForRequest:. The route index only asks such a route about requests that satisfy its constraints, so it
+ isn't checked against every URL routed through its scheme.
+ 
+ Called once each time the route index is rebuilt. The default implementation returns nil, which means any request could match.
+ Definitions that keep the default matching behavior are indexed by their pattern, and this is not called for them.
+ 
+ @returns The constraints every request this route matches satisfies, or nil if there aren't any.
+ */
+- (nullable JLRRouteMatchConstraints *)matchConstraints;
+
+
 /**
  Invoke handlerBlock with the given parameters. This may be overriden by subclasses.
  
@@ -108,6 +154,15 @@ NS_ASSUME_NONNULL_BEGIN
 - (BOOL)callHandlerBlockWithParameters:(NSDictionary *)parameters;
 
 
+/**
+ Invoke asyncHandlerBlock (or, if there is none, handlerBlock) with the given parameters. This may be overriden by subclasses.
+ 
+ @param parameters The parameters to pass to the handler block.
+ @param completion The block to call, exactly once and on any thread, with YES if the route was handled and NO if not.
+ */
+- (void)callHandlerBlockWithParameters:(NSDictionary *)parameters completion:(void (^)(BOOL handled))completion;
+
+
 ///---------------------------------
 /// @name Creating Match Parameters
 ///---------------------------------
@@ -124,7 +179,7 @@ NS_ASSUME_NONNULL_BEGIN
  @see defaultMatchParametersForRequest:
  @see routeVariablesForRequest:
  */
-- (NSDictionary *)matchParametersForRequest:(JLRRouteRequest *)request routeVariables:(NSDictionary <NSString *, NSString *> *)routeVariables;
+- (NSDictionary *)matchParametersForRequest:(JLRRouteRequest *)request routeVariables:(NSDictionary <NSString *, id> *)routeVariables;
 
 
 /**
@@ -145,15 +200,19 @@ NS_ASSUME_NONNULL_BEGIN
 /**
  Parses and returns route variables for the given request.
  
+ Variables are strings, except for those constrained to a type in the pattern: ':id<int>' is an NSNumber and ':id<uuid>' is an NSUUID.
+ A request with a path component that a variable's constraint doesn't accept is not a match.
+ 
  @param request The request to parse variable values from.
  
  @returns The parsed route variables if there was a match, or nil if it was not a match.
  */
-- (nullable NSDictionary <NSString *, NSString *> *)routeVariablesForRequest:(JLRRouteRequest *)request;
+- (nullable NSDictionary <NSString *, id> *)routeVariablesForRequest:(JLRRouteRequest *)request;
 
 
 /**
  Parses value into a variable name, including stripping out any extra characters if needed.
+ This is called once per variable when the route pattern is compiled, not on every request.
  
  @param value The raw string value that should be parsed into a variable name.
  
@@ -172,6 +231,36 @@ NS_ASSUME_NONNULL_BEGIN
 - (NSString *)routeVariableValueForValue:(NSString *)value;
 
 
+///-------------------------
+/// @name Recording Metrics
+///-------------------------
+
+
+/**
+ Records that the route was checked against a URL. JLRoutes calls this while routing when +[JLRoutes isMetricsEnabled] is YES.
+ 
+ @param matched YES if the route matched the URL.
+ */
+- (void)recordMatchAttempt:(BOOL)matched;
+
+
+/**
+ Records the result of calling the handler block. JLRoutes calls this while routing when +[JLRoutes isMetricsEnabled] is YES.
+ 
+ @param handled The value returned by -callHandlerBlockWithParameters:.
+ @param nanoseconds How long -callHandlerBlockWithParameters: took.
+ */
+- (void)recordHandlerResult:(BOOL)handled duration:(uint64_t)nanoseconds;
+
+
+/// Returns a snapshot of the route's recorded metrics.
+- (JLRRouteDefinitionMetrics *)metricsSnapshot;
+
+
+/// Sets all of the route's recorded metrics back to zero.
+- (void)resetMetrics;
+
+
 @end
 
 
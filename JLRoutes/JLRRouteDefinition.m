@@ -13,6 +13,136 @@
 #import "JLRRouteDefinition.h"
 #import "JLRoutes.h"
 #import "JLRParsingUtilities.h"
+#import "JLRMatchParameters.h"
+#import "JLRRouteTable.h"
+#import "JLRRouteStringPool.h"
+#import "JLRRouteOrdering.h"
+#import <objc/runtime.h>
+#import <stdatomic.h>
+
+
+// -enumerateCompiledPatternsUsingBlock: goes through every combination of optional groups, so it gives up past this many.
+static const NSUInteger JLRRouteDefinitionMaximumEnumeratedOptionalGroupCount = 8;
+
+
+// The UTF-8 bytes of a literal segment, so that it can be compared against a request's path components in place.
+typedef struct {
+    const char *bytes;
+    NSUInteger length;
+} JLRRouteLiteral;
+
+
+// One way of matching the groups before groupIndex against the path components before pathIndex, for the state (groupIndex, pathIndex).
+typedef struct {
+    NSUInteger patternLength;       // the length of the expanded pattern so far, or NSNotFound if the state can't be reached
+    uint64_t order;                 // a bit per included group, for breaking ties between equally long expanded patterns
+    NSUInteger previousPathIndex;   // the path index of the state this one was reached from
+    BOOL includesPreviousGroup;     // whether the group before groupIndex was included to get here
+} JLRRouteSegmentGroupMatchState;
+
+
+// Matches a single group against the request's path components from pathIndex onwards. On success, sets endPathIndex to the
+// path index right after the group, which is the end of the path for a group that ends with a wildcard.
+static BOOL JLRRouteMatchSegmentGroup(const JLRRouteSegment *segments, const JLRRouteLiteral *literals, JLRRouteSegmentGroup group, JLRRouteRequest *request, NSUInteger pathComponentCount, NSUInteger pathIndex, NSUInteger *endPathIndex)
+{
+    NSUInteger matchedCount = 0;
+    
+    for (NSUInteger index = group.location; index < group.location + group.length; index++) {
+        JLRRouteSegment segment = segments[index];
+        
+        if (segment.type == JLRRouteSegmentTypeWildcard) {
+            *endPathIndex = pathComponentCount;
+            return YES;
+        }
+        
+        if (pathIndex + matchedCount >= pathComponentCount || (segment.type == JLRRouteSegmentTypeLiteral && ![request pathComponentAtIndex:pathIndex + matchedCount isEqualToUTF8String:literals[index].bytes length:literals[index].length])) {
+            return NO;
+        }
+        
+        if (segment.constraint != nil && ![segment.constraint allowsPathComponentAtIndex:pathIndex + matchedCount ofRequest:request]) {
+            // a constrained variable that doesn't accept its path component fails the group, just like a different literal
+            return NO;
+        }
+        
+        matchedCount++;
+    }
+    
+    *endPathIndex = pathIndex + matchedCount;
+    return YES;
+}
+
+static BOOL JLRRouteSegmentGroupMatchIsBetter(NSUInteger patternLength, uint64_t order, JLRRouteSegmentGroupMatchState state)
+{
+    return state.patternLength == NSNotFound || patternLength > state.patternLength || (patternLength == state.patternLength && order < state.order);
+}
+
+static void JLRRouteRelaxSegmentGroupMatchState(JLRRouteSegmentGroupMatchState *state, NSUInteger patternLength, uint64_t order, NSUInteger previousPathIndex, BOOL includesPreviousGroup)
+{
+    if (JLRRouteSegmentGroupMatchIsBetter(patternLength, order, *state)) {
+        state->patternLength = patternLength;
+        state->order = order;
+        state->previousPathIndex = previousPathIndex;
+        state->includesPreviousGroup = includesPreviousGroup;
+    }
+}
+
+// Matches the groups against the request's path components, recording which optional groups were included. Of the combinations
+// of optional groups that match, the one whose expanded pattern is longest wins, and between equally long ones, the one that
+// leaves out the latest group. This is the order the expanded patterns were registered in when each was a separate route.
+// Since the length and the tie breaking bits both add up group by group, the best way to reach each state (groupIndex, pathIndex)
+// is only worked out once, no matter how many optional groups there are.
+static BOOL JLRRouteMatchSegmentGroups(const JLRRouteSegment *segments, const JLRRouteLiteral *literals, const JLRRouteSegmentGroup *groups, const NSUInteger *groupPatternLengths, NSUInteger groupCount, JLRRouteRequest *request, NSUInteger pathComponentCount, BOOL *includedGroups, JLRRouteSegmentGroupMatchState *states)
+{
+    NSUInteger stride = pathComponentCount + 1;
+    
+    for (NSUInteger index = 0; index < (groupCount + 1) * stride; index++) {
+        states[index].patternLength = NSNotFound;
+    }
+    states[0].patternLength = 0;
+    states[0].order = 0;
+    
+    for (NSUInteger groupIndex = 0; groupIndex < groupCount; groupIndex++) {
+        JLRRouteSegmentGroup group = groups[groupIndex];
+        uint64_t groupOrder = groupIndex < 64 ? (1ULL << groupIndex) : 0;
+        
+        for (NSUInteger pathIndex = 0; pathIndex <= pathComponentCount; pathIndex++) {
+            JLRRouteSegmentGroupMatchState state = states[groupIndex * stride + pathIndex];
+            if (state.patternLength == NSNotFound) {
+                continue;
+            }
+            
+            if (group.optional) {
+                JLRRouteRelaxSegmentGroupMatchState(&states[(groupIndex + 1) * stride + pathIndex], state.patternLength, state.order, pathIndex, NO);
+            }
+            
+            NSUInteger endPathIndex = 0;
+            if (JLRRouteMatchSegmentGroup(segments, literals, group, request, pathComponentCount, pathIndex, &endPathIndex)) {
+                JLRRouteRelaxSegmentGroupMatchState(&states[(groupIndex + 1) * stride + endPathIndex], state.patternLength + groupPatternLengths[groupIndex], state.order + groupOrder, pathIndex, YES);
+            }
+        }
+    }
+    
+    JLRRouteSegmentGroupMatchState *finalStates = &states[groupCount * stride];
+    NSUInteger pathIndex = pathComponentCount;
+    
+    if (pathComponentCount == 1 && finalStates[0].patternLength != NSNotFound && JLRRouteSegmentGroupMatchIsBetter(finalStates[0].patternLength, finalStates[0].order, finalStates[1]) && [request pathComponentAtIndex:0 isEqualToUTF8String:"" length:0]) {
+        // without any of its optional groups, a pattern like '/(a)' is '/', which matches the single empty path component
+        pathIndex = 0;
+    }
+    
+    if (finalStates[pathIndex].patternLength == NSNotFound) {
+        return NO;
+    }
+    
+    // walk back from the final state to find out which groups got there
+    for (NSUInteger groupIndex = groupCount; groupIndex > 0; groupIndex--) {
+        JLRRouteSegmentGroupMatchState state = states[groupIndex * stride + pathIndex];
+        includedGroups[groupIndex - 1] = state.includesPreviousGroup;
+        pathIndex = state.previousPathIndex;
+    }
+    
+    return YES;
+}
 
 
 @interface JLRRouteDefinition ()
@@ -21,12 +151,39 @@
 @property (nonatomic, copy) NSString *scheme;
 @property (nonatomic, assign) NSUInteger priority;
 @property (nonatomic, copy) NSArray *patternPathComponents;
+@property (nonatomic, assign) NSUInteger leadingRequiredPathComponentCount;
 @property (nonatomic, copy) BOOL (^handlerBlock)(NSDictionary *parameters);
+@property (nonatomic, copy) void (^asyncHandlerBlock)(NSDictionary *parameters, void (^completion)(BOOL handled));
+@property (nonatomic, copy) NSArray <NSString *> *segmentValues;
+@property (nonatomic, copy) NSArray <JLRRouteVariableConstraint *> *segmentConstraints;
+
+- (instancetype)initWithPattern:(NSString *)pattern priority:(NSUInteger)priority handlerBlock:(BOOL (^)(NSDictionary *parameters))handlerBlock patternPathComponents:(NSArray <NSString *> *)patternPathComponents leadingRequiredPathComponentCount:(NSUInteger)leadingRequiredPathComponentCount segments:(const JLRRouteSegment *)segments segmentCount:(NSUInteger)segmentCount groups:(const JLRRouteSegmentGroup *)groups groupCount:(NSUInteger)groupCount minimumPathComponentCount:(NSUInteger)minimumPathComponentCount maximumPathComponentCount:(NSUInteger)maximumPathComponentCount NS_DESIGNATED_INITIALIZER;
 
 @end
 
 
 @implementation JLRRouteDefinition
+{
+    JLRRouteSegment *_segments;
+    NSUInteger _segmentCount;
+    JLRRouteLiteral *_literals;
+    char *_literalBytes;
+    NSUInteger _minimumPathComponentCount;
+    NSUInteger _maximumPathComponentCount;
+    JLRRouteSegmentGroup *_groups;
+    NSUInteger _groupCount;
+    NSUInteger *_groupPatternLengths;
+    
+    // metrics, updated concurrently by every thread routing through this route
+    _Atomic(uint64_t) _matchAttemptCount;
+    _Atomic(uint64_t) _matchCount;
+    _Atomic(uint64_t) _handledCount;
+    _Atomic(uint64_t) _declinedCount;
+    _Atomic(uint64_t) _handlerNanoseconds;
+    
+    // how often this route handled a URL, for adaptive ordering
+    _Atomic(uint64_t) _orderingHitCount;
+}
 
 - (instancetype)initWithPattern:(NSString *)pattern priority:(NSUInteger)priority handlerBlock:(BOOL (^)(NSDictionary *parameters))handlerBlock
 {
@@ -37,15 +194,94 @@
         self.priority = priority;
         self.handlerBlock = handlerBlock;
         
-        if ([pattern length] > 0 && [pattern characterAtIndex:0] == '/') {
-            pattern = [pattern substringFromIndex:1];
+        NSArray <JLRParsingUtilities_RouteSubpath *> *subpaths = nil;
+        
+        if ([pattern rangeOfString:@"("].location != NSNotFound) {
+            // optional groups are matched in place, so the pattern path components include all of them
+            subpaths = [JLRParsingUtilities routeSubpathsForPattern:pattern];
+            
+            NSMutableArray <NSString *> *patternPathComponents = [NSMutableArray array];
+            for (JLRParsingUtilities_RouteSubpath *subpath in subpaths) {
+                [patternPathComponents addObjectsFromArray:subpath.subpathComponents];
+            }
+            self.patternPathComponents = patternPathComponents;
+        } else {
+            if ([pattern length] > 0 && [pattern characterAtIndex:0] == '/') {
+                pattern = [pattern substringFromIndex:1];
+            }
+            
+            self.patternPathComponents = [pattern componentsSeparatedByString:@"/"];
         }
         
-        self.patternPathComponents = [pattern componentsSeparatedByString:@"/"];
+        [self _compilePatternPathComponents];
+        [self _compileLiterals];
+        [self _compileSegmentGroupsForSubpaths:subpaths];
+        [self _compileSegmentGroupPatternLengths];
     }
     return self;
 }
 
+- (instancetype)initWithPattern:(NSString *)pattern priority:(NSUInteger)priority handlerBlock:(BOOL (^)(NSDictionary *parameters))handlerBlock patternPathComponents:(NSArray <NSString *> *)patternPathComponents leadingRequiredPathComponentCount:(NSUInteger)leadingRequiredPathComponentCount segments:(const JLRRouteSegment *)segments segmentCount:(NSUInteger)segmentCount groups:(const JLRRouteSegmentGroup *)groups groupCount:(NSUInteger)groupCount minimumPathComponentCount:(NSUInteger)minimumPathComponentCount maximumPathComponentCount:(NSUInteger)maximumPathComponentCount
+{
+    NSParameterAssert(pattern != nil);
+    
+    if ((self = [super init])) {
+        self.pattern = pattern;
+        self.priority = priority;
+        self.handlerBlock = handlerBlock;
+        self.patternPathComponents = patternPathComponents;
+        self.leadingRequiredPathComponentCount = leadingRequiredPathComponentCount;
+        
+        NSMutableArray <NSString *> *segmentValues = [NSMutableArray arrayWithCapacity:segmentCount];
+        NSMutableArray <JLRRouteVariableConstraint *> *segmentConstraints = [NSMutableArray array];
+        
+        _segments = calloc(MAX(segmentCount, 1UL), sizeof(JLRRouteSegment));
+        _segmentCount = segmentCount;
+        for (NSUInteger index = 0; index < segmentCount; index++) {
+            _segments[index] = segments[index];
+            if (segments[index].value != nil) {
+                [segmentValues addObject:segments[index].value];
+            }
+            if (segments[index].constraint != nil) {
+                [segmentConstraints addObject:segments[index].constraint];
+            }
+        }
+        
+        // segmentValues and segmentConstraints keep the unretained segment values and constraints alive
+        self.segmentValues = segmentValues;
+        self.segmentConstraints = segmentConstraints;
+        [self _compileLiterals];
+        
+        if (groupCount > 0) {
+            _groups = calloc(groupCount, sizeof(JLRRouteSegmentGroup));
+            memcpy(_groups, groups, groupCount * sizeof(JLRRouteSegmentGroup));
+            _groupCount = groupCount;
+            [self _compileSegmentGroupPatternLengths];
+        }
+        
+        _minimumPathComponentCount = minimumPathComponentCount;
+        _maximumPathComponentCount = maximumPathComponentCount;
+    }
+    return self;
+}
+
+- (instancetype)initWithPattern:(NSString *)pattern priority:(NSUInteger)priority asyncHandlerBlock:(void (^)(NSDictionary *parameters, void (^completion)(BOOL handled)))asyncHandlerBlock
+{
+    if ((self = [self initWithPattern:pattern priority:priority handlerBlock:nil])) {
+        self.asyncHandlerBlock = asyncHandlerBlock;
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    free(_segments);
+    free(_literals);
+    free(_literalBytes);
+    free(_groups);
+    free(_groupPatternLengths);
+}
+
 - (NSString *)description
 {
     return [NSString stringWithFormat:@"<%@ %p> - %@ (priority: %@)", NSStringFromClass([self class]), self, self.pattern, @(self.priority)];
@@ -94,9 +330,9 @@
 
 - (JLRRouteResponse *)routeResponseForRequest:(JLRRouteRequest *)request
 {
-    BOOL patternContainsWildcard = [self.patternPathComponents containsObject:@"*"];
+    NSUInteger pathComponentCount = request.pathComponentCount;
     
-    if (request.pathComponents.count != self.patternPathComponents.count && !patternContainsWildcard) {
+    if (pathComponentCount < _minimumPathComponentCount || pathComponentCount > _maximumPathComponentCount) {
         // definitely not a match, nothing left to do
         return [JLRRouteResponse invalidMatchResponse];
     }
@@ -113,8 +349,18 @@
     }
 }
 
+- (JLRRouteMatchConstraints *)matchConstraints
+{
+    return nil;
+}
+
 - (BOOL)callHandlerBlockWithParameters:(NSDictionary *)parameters
 {
+    if (self.asyncHandlerBlock != nil) {
+        // only asynchronous routing can wait for the result, so routing synchronously leaves the route to the next matching one
+        return NO;
+    }
+    
     if (self.handlerBlock == nil) {
         return YES;
     }
@@ -122,6 +368,15 @@
     return self.handlerBlock(parameters);
 }
 
+- (void)callHandlerBlockWithParameters:(NSDictionary *)parameters completion:(void (^)(BOOL handled))completion
+{
+    if (self.asyncHandlerBlock != nil) {
+        self.asyncHandlerBlock(parameters, completion);
+    } else {
+        completion([self callHandlerBlockWithParameters:parameters]);
+    }
+}
+
 - (void)didBecomeRegisteredForScheme:(NSString *)scheme
 {
     NSAssert(self.scheme == nil, @"Route definitions should not be added to multiple schemes.");
@@ -130,59 +385,99 @@
 
 #pragma mark - Parsing Route Variables
 
-- (NSDictionary <NSString *, NSString *> *)routeVariablesForRequest:(JLRRouteRequest *)request
+- (NSDictionary <NSString *, id> *)routeVariablesForRequest:(JLRRouteRequest *)request
 {
-    NSMutableDictionary *routeVariables = [NSMutableDictionary dictionary];
+    NSUInteger pathComponentCount = request.pathComponentCount;
     
-    BOOL isMatch = YES;
-    NSUInteger index = 0;
+    if (pathComponentCount < _minimumPathComponentCount) {
+        // not a match: /a/b/c/* cannot be matched by URL /a/b/
+        return nil;
+    }
     
-    for (NSString *patternComponent in self.patternPathComponents) {
-        NSString *URLComponent = nil;
-        BOOL isPatternComponentWildcard = [patternComponent isEqualToString:@"*"];
-        
-        if (index < [request.pathComponents count]) {
-            URLComponent = request.pathComponents[index];
-        } else if (!isPatternComponentWildcard) {
-            // URLComponent is not a wildcard and index is >= request.pathComponents.count, so bail
-            isMatch = NO;
-            break;
+    if (pathComponentCount > _maximumPathComponentCount) {
+        // not a match: /a/b cannot be matched by URL /a/b/c
+        return nil;
+    }
+    
+    if (_groupCount > 0) {
+        return [self _routeVariablesForSegmentGroupsInRequest:request];
+    }
+    
+    // check all static components (and constrained variables) against the request's path in place, so that mismatches don't allocate anything
+    for (NSUInteger index = 0; index < _segmentCount; index++) {
+        if (_segments[index].type == JLRRouteSegmentTypeLiteral && ![request pathComponentAtIndex:index isEqualToUTF8String:_literals[index].bytes length:_literals[index].length]) {
+            return nil;
         }
+        if (_segments[index].constraint != nil && ![_segments[index].constraint allowsPathComponentAtIndex:index ofRequest:request]) {
+            return nil;
+        }
+    }
+    
+    NSMutableDictionary *routeVariables = [NSMutableDictionary dictionary];
+    BOOL decodePlusSymbols = ((request.options & JLRRouteRequestOptionDecodePlusSymbols) == JLRRouteRequestOptionDecodePlusSymbols);
+    
+    for (NSUInteger index = 0; index < _segmentCount; index++) {
+        JLRRouteSegment segment = _segments[index];
         
-        if ([patternComponent hasPrefix:@":"]) {
+        if (segment.type == JLRRouteSegmentTypeVariable) {
             // this is a variable, set it in the params
-            NSAssert(URLComponent != nil, @"URLComponent cannot be nil");
-            NSString *variableName = [self routeVariableNameForValue:patternComponent];
-            NSString *variableValue = [self routeVariableValueForValue:URLComponent];
-            
-            // Consult the parsing utilities as well to do any other standard variable transformations
-            BOOL decodePlusSymbols = ((request.options & JLRRouteRequestOptionDecodePlusSymbols) == JLRRouteRequestOptionDecodePlusSymbols);
-            variableValue = [JLRParsingUtilities variableValueFrom:variableValue decodePlusSymbols:decodePlusSymbols];
+            id value = [self _routeVariableValueForSegment:segment request:request pathComponentIndex:index decodePlusSymbols:decodePlusSymbols];
+            if (value == nil && segment.constraint != nil) {
+                return nil;
+            }
+            routeVariables[segment.value] = value;
+        } else if (segment.type == JLRRouteSegmentTypeWildcard) {
+            // match: /a/b/c/* has to be matched by at least /a/b/c
+            routeVariables[JLRouteWildcardComponentsKey] = [request.pathComponents subarrayWithRange:NSMakeRange(index, pathComponentCount - index)];
+        }
+    }
+    
+    return [routeVariables copy];
+}
+
+- (NSDictionary <NSString *, id> *)_routeVariablesForSegmentGroupsInRequest:(JLRRouteRequest *)request
+{
+    NSUInteger pathComponentCount = request.pathComponentCount;
+    NSUInteger stateCount = (_groupCount + 1) * (pathComponentCount + 1);
+    JLRRouteSegmentGroupMatchState stackStates[64];
+    BOOL stackIncludedGroups[32] = {NO};
+    JLRRouteSegmentGroupMatchState *states = stateCount <= 64 ? stackStates : calloc(stateCount, sizeof(JLRRouteSegmentGroupMatchState));
+    BOOL *includedGroups = _groupCount <= 32 ? stackIncludedGroups : calloc(_groupCount, sizeof(BOOL));
+    NSMutableDictionary *routeVariables = nil;
+    
+    if (JLRRouteMatchSegmentGroups(_segments, _literals, _groups, _groupPatternLengths, _groupCount, request, pathComponentCount, includedGroups, states)) {
+        routeVariables = [NSMutableDictionary dictionary];
+        BOOL decodePlusSymbols = ((request.options & JLRRouteRequestOptionDecodePlusSymbols) == JLRRouteRequestOptionDecodePlusSymbols);
+        NSUInteger pathIndex = 0;
+        
+        for (NSUInteger groupIndex = 0; groupIndex < _groupCount && routeVariables != nil; groupIndex++) {
+            if (!includedGroups[groupIndex]) {
+                continue;
+            }
             
-            routeVariables[variableName] = variableValue;
-        } else if (isPatternComponentWildcard) {
-            // match wildcards
-            NSUInteger minRequiredParams = index;
-            if (request.pathComponents.count >= minRequiredParams) {
-                // match: /a/b/c/* has to be matched by at least /a/b/c
-                routeVariables[JLRouteWildcardComponentsKey] = [request.pathComponents subarrayWithRange:NSMakeRange(index, request.pathComponents.count - index)];
-                isMatch = YES;
-            } else {
-                // not a match: /a/b/c/* cannot be matched by URL /a/b/
-                isMatch = NO;
+            JLRRouteSegmentGroup group = _groups[groupIndex];
+            for (NSUInteger index = group.location; index < group.location + group.length; index++, pathIndex++) {
+                JLRRouteSegment segment = _segments[index];
+                
+                if (segment.type == JLRRouteSegmentTypeVariable) {
+                    id value = [self _routeVariableValueForSegment:segment request:request pathComponentIndex:pathIndex decodePlusSymbols:decodePlusSymbols];
+                    if (value == nil && segment.constraint != nil) {
+                        routeVariables = nil;
+                        break;
+                    }
+                    routeVariables[segment.value] = value;
+                } else if (segment.type == JLRRouteSegmentTypeWildcard) {
+                    routeVariables[JLRouteWildcardComponentsKey] = [request.pathComponents subarrayWithRange:NSMakeRange(pathIndex, pathComponentCount - pathIndex)];
+                }
             }
-            break;
-        } else if (![patternComponent isEqualToString:URLComponent]) {
-            // break if this is a static component and it isn't a match
-            isMatch = NO;
-            break;
         }
-        index++;
     }
     
-    if (!isMatch) {
-        // Return nil to indicate that there was not a match
-        routeVariables = nil;
+    if (states != stackStates) {
+        free(states);
+    }
+    if (includedGroups != stackIncludedGroups) {
+        free(includedGroups);
     }
     
     return [routeVariables copy];
@@ -208,8 +503,13 @@
 - (NSString *)routeVariableValueForValue:(NSString *)value
 {
     // Remove percent encoding
-    NSString *var = [value stringByRemovingPercentEncoding];
+    NSString *var = [JLRParsingUtilities stringByDecodingString:value removePercentEncoding:YES decodePlusSymbols:NO];
     
+    return [self _routeVariableValueByStrippingFragment:var];
+}
+
+- (NSString *)_routeVariableValueByStrippingFragment:(NSString *)var
+{
     if (var.length > 1 && [var characterAtIndex:var.length - 1] == '#') {
         // Strip of trailing fragment
         var = [var substringToIndex:var.length - 1];
@@ -218,33 +518,390 @@
     return var;
 }
 
+- (id)_routeVariableValueForSegment:(JLRRouteSegment)segment request:(JLRRouteRequest *)request pathComponentIndex:(NSUInteger)index decodePlusSymbols:(BOOL)decodePlusSymbols
+{
+    NSString *value = [self _routeVariableValueForRequest:request pathComponentIndex:index decodePlusSymbols:decodePlusSymbols];
+    
+    // constrained variables are delivered as their typed value, which is nil if a customized value isn't accepted after all
+    return segment.constraint != nil ? [segment.constraint valueForString:value] : value;
+}
+
+- (NSString *)_routeVariableValueForRequest:(JLRRouteRequest *)request pathComponentIndex:(NSUInteger)index decodePlusSymbols:(BOOL)decodePlusSymbols
+{
+    if ([[self class] instanceMethodForSelector:@selector(routeVariableValueForValue:)] != [JLRRouteDefinition instanceMethodForSelector:@selector(routeVariableValueForValue:)]) {
+        // a subclass customized the value, so it has to be given the path component as a string
+        NSString *variableValue = [self routeVariableValueForValue:request.pathComponents[index]];
+        
+        // Consult the parsing utilities as well to do any other standard variable transformations
+        return [JLRParsingUtilities variableValueFrom:variableValue decodePlusSymbols:decodePlusSymbols];
+    }
+    
+    // otherwise percent encoding and plus symbols are decoded straight from the request's path in one pass
+    NSUInteger length = 0;
+    const char *bytes = [request UTF8StringForPathComponentAtIndex:index length:&length];
+    NSString *variableValue = [JLRParsingUtilities stringByDecodingUTF8Bytes:bytes length:length removePercentEncoding:YES decodePlusSymbols:decodePlusSymbols];
+    
+    return [self _routeVariableValueByStrippingFragment:variableValue];
+}
+
 #pragma mark - Creating Match Parameters
 
-- (NSDictionary *)matchParametersForRequest:(JLRRouteRequest *)request routeVariables:(NSDictionary <NSString *, NSString *> *)routeVariables
+- (NSDictionary *)matchParametersForRequest:(JLRRouteRequest *)request routeVariables:(NSDictionary <NSString *, id> *)routeVariables
 {
-    NSMutableDictionary *matchParams = [NSMutableDictionary dictionary];
+    // The query parameters ('?a=b&c=d', including fragment), route variables, additional parameters and base parameters
+    // are looked up in place, last to first. The base parameters come first so that they cannot be overriden by using
+    // the same key in your route or query.
+    return [[JLRMatchParameters alloc] initWithRequest:request routeVariables:routeVariables defaultParameters:[self defaultMatchParametersForRequest:request]];
+}
+
+- (NSDictionary *)defaultMatchParametersForRequest:(JLRRouteRequest *)request
+{
+    return @{JLRoutePatternKey: self.pattern ?: [NSNull null], JLRouteURLKey: request.URL ?: [NSNull null], JLRouteSchemeKey: self.scheme ?: [NSNull null]};
+}
+
+#pragma mark - Compiling Patterns
+
+- (void)_compilePatternPathComponents
+{
+    NSArray <NSString *> *patternPathComponents = self.patternPathComponents;
+    NSMutableArray <NSString *> *segmentValues = [NSMutableArray arrayWithCapacity:patternPathComponents.count];
+    NSMutableArray <JLRRouteVariableConstraint *> *segmentConstraints = [NSMutableArray array];
     
-    // Add the parsed query parameters ('?a=b&c=d'). Also includes fragment.
-    BOOL decodePlusSymbols = ((request.options & JLRRouteRequestOptionDecodePlusSymbols) == JLRRouteRequestOptionDecodePlusSymbols);
-    [matchParams addEntriesFromDictionary:[JLRParsingUtilities queryParams:request.queryParams decodePlusSymbols:decodePlusSymbols]];
+    _segments = calloc(MAX(patternPathComponents.count, 1UL), sizeof(JLRRouteSegment));
+    _segmentCount = 0;
+    _minimumPathComponentCount = patternPathComponents.count;
+    _maximumPathComponentCount = patternPathComponents.count;
     
-    // Add the actual parsed route variables (the items in the route prefixed with ':').
-    [matchParams addEntriesFromDictionary:routeVariables];
+    for (NSString *patternComponent in patternPathComponents) {
+        JLRRouteSegment *segment = &_segments[_segmentCount];
+        
+        if ([patternComponent isEqualToString:@"*"]) {
+            // anything after a wildcard is never looked at, so it ends the compiled pattern
+            segment->type = JLRRouteSegmentTypeWildcard;
+            _minimumPathComponentCount = _segmentCount;
+            _maximumPathComponentCount = NSUIntegerMax;
+            _segmentCount++;
+            break;
+        }
+        
+        NSString *value = nil;
+        if ([patternComponent hasPrefix:@":"]) {
+            NSString *constraintString = nil;
+            segment->type = JLRRouteSegmentTypeVariable;
+            value = [self routeVariableNameForValue:[JLRParsingUtilities patternComponentByRemovingVariableConstraint:patternComponent constraint:&constraintString]];
+            
+            if (constraintString != nil) {
+                JLRRouteVariableConstraint *constraint = [JLRRouteVariableConstraint constraintWithString:constraintString];
+                [segmentConstraints addObject:constraint];
+                segment->constraint = constraint;
+            }
+        } else {
+            segment->type = JLRRouteSegmentTypeLiteral;
+            value = patternComponent;
+        }
+        
+        [segmentValues addObject:value];
+        segment->value = value;
+        _segmentCount++;
+    }
     
-    // Add the additional parameters, if any were specified in the request.
-    if (request.additionalParameters != nil) {
-        [matchParams addEntriesFromDictionary:request.additionalParameters];
+    // segmentValues and segmentConstraints keep the unretained segment values and constraints alive
+    self.segmentValues = segmentValues;
+    self.segmentConstraints = segmentConstraints;
+}
+
+- (void)_compileLiterals
+{
+    // all literals are copied into one buffer, which each segment's literal points into
+    NSUInteger bufferLength = 0;
+    for (NSUInteger index = 0; index < _segmentCount; index++) {
+        if (_segments[index].type == JLRRouteSegmentTypeLiteral) {
+            bufferLength += [_segments[index].value lengthOfBytesUsingEncoding:NSUTF8StringEncoding];
+        }
     }
     
-    // Finally, add the base parameters. This is done last so that these cannot be overriden by using the same key in your route or query.
-    [matchParams addEntriesFromDictionary:[self defaultMatchParametersForRequest:request]];
+    _literals = calloc(MAX(_segmentCount, 1UL), sizeof(JLRRouteLiteral));
+    _literalBytes = malloc(MAX(bufferLength, 1UL));
     
-    return [matchParams copy];
+    NSUInteger offset = 0;
+    for (NSUInteger index = 0; index < _segmentCount; index++) {
+        NSString *value = _segments[index].value;
+        if (_segments[index].type != JLRRouteSegmentTypeLiteral) {
+            continue;
+        }
+        
+        NSUInteger length = 0;
+        [value getBytes:_literalBytes + offset maxLength:bufferLength - offset usedLength:&length encoding:NSUTF8StringEncoding options:0 range:NSMakeRange(0, value.length) remainingRange:NULL];
+        _literals[index].bytes = _literalBytes + offset;
+        _literals[index].length = length;
+        offset += length;
+    }
 }
 
-- (NSDictionary *)defaultMatchParametersForRequest:(JLRRouteRequest *)request
+- (void)_compileSegmentGroupsForSubpaths:(NSArray <JLRParsingUtilities_RouteSubpath *> *)subpaths
 {
-    return @{JLRoutePatternKey: self.pattern ?: [NSNull null], JLRouteURLKey: request.URL ?: [NSNull null], JLRouteSchemeKey: self.scheme ?: [NSNull null]};
+    self.leadingRequiredPathComponentCount = self.patternPathComponents.count;
+    
+    if (subpaths.count == 0) {
+        return;
+    }
+    
+    _groups = calloc(subpaths.count, sizeof(JLRRouteSegmentGroup));
+    _groupCount = 0;
+    _minimumPathComponentCount = 0;
+    _maximumPathComponentCount = 0;
+    
+    NSUInteger location = 0;
+    BOOL foundOptionalGroup = NO;
+    
+    for (JLRParsingUtilities_RouteSubpath *subpath in subpaths) {
+        if (location >= _segmentCount) {
+            // this is past a wildcard, which already matches everything
+            break;
+        }
+        
+        JLRRouteSegmentGroup *group = &_groups[_groupCount++];
+        group->location = location;
+        group->length = MIN(subpath.subpathComponents.count, _segmentCount - location);
+        group->optional = subpath.isOptionalSubpath;
+        location += group->length;
+        
+        if (group->optional && !foundOptionalGroup) {
+            foundOptionalGroup = YES;
+            self.leadingRequiredPathComponentCount = group->location;
+        }
+        
+        BOOL endsWithWildcard = (_segments[location - 1].type == JLRRouteSegmentTypeWildcard);
+        NSUInteger matchedLength = endsWithWildcard ? group->length - 1 : group->length;
+        
+        if (!group->optional) {
+            _minimumPathComponentCount += matchedLength;
+        }
+        _maximumPathComponentCount = endsWithWildcard ? NSUIntegerMax : _maximumPathComponentCount + matchedLength;
+        
+        if (endsWithWildcard) {
+            break;
+        }
+    }
+    
+    if (!foundOptionalGroup) {
+        // a wildcard came before any optional group, so it matches just like a pattern without any
+        free(_groups);
+        _groups = NULL;
+        _groupCount = 0;
+    }
+}
+
+- (void)_compileSegmentGroupPatternLengths
+{
+    if (_groupCount == 0) {
+        return;
+    }
+    
+    // how much each group adds to the length of an expanded pattern ('/' followed by its components), which decides between combinations
+    NSArray <NSString *> *patternPathComponents = self.patternPathComponents;
+    _groupPatternLengths = calloc(_groupCount, sizeof(NSUInteger));
+    
+    for (NSUInteger groupIndex = 0; groupIndex < _groupCount; groupIndex++) {
+        JLRRouteSegmentGroup group = _groups[groupIndex];
+        for (NSUInteger index = group.location; index < group.location + group.length && index < patternPathComponents.count; index++) {
+            _groupPatternLengths[groupIndex] += patternPathComponents[index].length + 1;
+        }
+    }
+}
+
+#pragma mark - Route Tables
+
+- (const JLRRouteSegment *)compiledSegments
+{
+    return _segments;
+}
+
+- (NSUInteger)compiledSegmentCount
+{
+    return _segmentCount;
+}
+
+- (const JLRRouteSegmentGroup *)compiledSegmentGroups
+{
+    return _groups;
+}
+
+- (NSUInteger)compiledSegmentGroupCount
+{
+    return _groupCount;
+}
+
+- (NSUInteger)minimumPathComponentCount
+{
+    return _minimumPathComponentCount;
+}
+
+- (NSUInteger)maximumPathComponentCount
+{
+    return _maximumPathComponentCount;
+}
+
+- (BOOL)enumerateCompiledPatternsUsingBlock:(void (^)(const JLRRouteSegment *segments, NSUInteger count, BOOL endsWithWildcard))block
+{
+    if (_groupCount == 0) {
+        BOOL endsWithWildcard = (_segmentCount > 0 && _segments[_segmentCount - 1].type == JLRRouteSegmentTypeWildcard);
+        block(_segments, endsWithWildcard ? _segmentCount - 1 : _segmentCount, endsWithWildcard);
+        return YES;
+    }
+    
+    NSUInteger optionalGroupCount = 0;
+    for (NSUInteger groupIndex = 0; groupIndex < _groupCount; groupIndex++) {
+        optionalGroupCount += _groups[groupIndex].optional ? 1 : 0;
+    }
+    
+    if (optionalGroupCount > JLRRouteDefinitionMaximumEnumeratedOptionalGroupCount) {
+        return NO;
+    }
+    
+    JLRRouteSegment *expandedSegments = calloc(MAX(_segmentCount, 1UL), sizeof(JLRRouteSegment));
+    
+    for (NSUInteger combination = 0; combination < (1UL << optionalGroupCount); combination++) {
+        NSUInteger count = 0;
+        NSUInteger optionalGroupIndex = 0;
+        BOOL endsWithWildcard = NO;
+        
+        for (NSUInteger groupIndex = 0; groupIndex < _groupCount && !endsWithWildcard; groupIndex++) {
+            JLRRouteSegmentGroup group = _groups[groupIndex];
+            if (group.optional && (combination & (1UL << optionalGroupIndex++)) == 0) {
+                continue;
+            }
+            
+            for (NSUInteger index = group.location; index < group.location + group.length; index++) {
+                if (_segments[index].type == JLRRouteSegmentTypeWildcard) {
+                    endsWithWildcard = YES;
+                    break;
+                }
+                expandedSegments[count++] = _segments[index];
+            }
+        }
+        
+        block(expandedSegments, count, endsWithWildcard);
+        
+        if (count == 0 && !endsWithWildcard) {
+            // without any of its groups, a pattern like '/(a)' also matches the single empty path component
+            JLRRouteSegment emptySegment = {JLRRouteSegmentTypeLiteral, @"", nil};
+            block(&emptySegment, 1, NO);
+        }
+    }
+    
+    free(expandedSegments);
+    
+    return YES;
+}
+
+#pragma mark - Interning Strings
+
+- (void)internStringsWithPool:(JLRRouteStringPool *)pool
+{
+    self.pattern = [pool internedString:self.pattern];
+    
+    NSMutableArray <NSString *> *patternPathComponents = [NSMutableArray arrayWithCapacity:self.patternPathComponents.count];
+    for (NSString *component in self.patternPathComponents) {
+        [patternPathComponents addObject:[pool internedString:component]];
+    }
+    self.patternPathComponents = patternPathComponents;
+    
+    NSMutableArray <NSString *> *segmentValues = [NSMutableArray arrayWithCapacity:_segmentCount];
+    for (NSUInteger index = 0; index < _segmentCount; index++) {
+        if (_segments[index].value != nil) {
+            NSString *value = [pool internedString:_segments[index].value];
+            [segmentValues addObject:value];
+            _segments[index].value = value;
+        }
+    }
+    
+    // segmentValues keeps the unretained segment values alive, so it's only replaced once they all point at pooled strings
+    self.segmentValues = segmentValues;
+}
+
+- (NSUInteger)estimatedMemoryUsageExcludingStringsInPool:(JLRRouteStringPool *)pool
+{
+    NSUInteger literalByteCount = 0;
+    for (NSUInteger index = 0; index < _segmentCount; index++) {
+        literalByteCount += _literals[index].length;
+    }
+    
+    NSUInteger usage = class_getInstanceSize([self class]);
+    usage += MAX(_segmentCount, 1UL) * (sizeof(JLRRouteSegment) + sizeof(JLRRouteLiteral)) + MAX(literalByteCount, 1UL);
+    usage += _groupCount * (sizeof(JLRRouteSegmentGroup) + sizeof(NSUInteger));
+    
+    // the arrays themselves, which hold a pointer per element
+    usage += (self.patternPathComponents.count + self.segmentValues.count + self.segmentConstraints.count + 5) * sizeof(void *);
+    
+    NSMutableArray <NSString *> *strings = [NSMutableArray arrayWithObject:self.pattern];
+    [strings addObjectsFromArray:self.patternPathComponents];
+    [strings addObjectsFromArray:self.segmentValues];
+    
+    NSHashTable <NSString *> *countedStrings = [NSHashTable hashTableWithOptions:NSPointerFunctionsObjectPointerPersonality];
+    for (NSString *string in strings) {
+        if (![countedStrings containsObject:string] && ![pool containsInternedString:string]) {
+            [countedStrings addObject:string];
+            usage += [JLRRouteStringPool estimatedMemoryUsageOfString:string];
+        }
+    }
+    
+    return usage;
+}
+
+#pragma mark - Recording Metrics
+
+- (void)recordMatchAttempt:(BOOL)matched
+{
+    atomic_fetch_add_explicit(&_matchAttemptCount, 1, memory_order_relaxed);
+    if (matched) {
+        atomic_fetch_add_explicit(&_matchCount, 1, memory_order_relaxed);
+    }
+}
+
+- (void)recordHandlerResult:(BOOL)handled duration:(uint64_t)nanoseconds
+{
+    atomic_fetch_add_explicit(handled ? &_handledCount : &_declinedCount, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&_handlerNanoseconds, nanoseconds, memory_order_relaxed);
+}
+
+- (JLRRouteDefinitionMetrics *)metricsSnapshot
+{
+    NSUInteger matchAttemptCount = (NSUInteger)atomic_load_explicit(&_matchAttemptCount, memory_order_relaxed);
+    NSUInteger matchCount = (NSUInteger)atomic_load_explicit(&_matchCount, memory_order_relaxed);
+    NSUInteger handledCount = (NSUInteger)atomic_load_explicit(&_handledCount, memory_order_relaxed);
+    NSUInteger declinedCount = (NSUInteger)atomic_load_explicit(&_declinedCount, memory_order_relaxed);
+    NSTimeInterval handlerDuration = (NSTimeInterval)atomic_load_explicit(&_handlerNanoseconds, memory_order_relaxed) / NSEC_PER_SEC;
+    
+    return [[JLRRouteDefinitionMetrics alloc] initWithMatchAttemptCount:matchAttemptCount matchCount:matchCount handledCount:handledCount declinedCount:declinedCount handlerDuration:handlerDuration];
+}
+
+- (void)resetMetrics
+{
+    atomic_store_explicit(&_matchAttemptCount, 0, memory_order_relaxed);
+    atomic_store_explicit(&_matchCount, 0, memory_order_relaxed);
+    atomic_store_explicit(&_handledCount, 0, memory_order_relaxed);
+    atomic_store_explicit(&_declinedCount, 0, memory_order_relaxed);
+    atomic_store_explicit(&_handlerNanoseconds, 0, memory_order_relaxed);
+}
+
+#pragma mark - Ordering by Use
+
+- (void)recordOrderingHit
+{
+    atomic_fetch_add_explicit(&_orderingHitCount, 1, memory_order_relaxed);
+}
+
+- (NSUInteger)orderingHitCount
+{
+    return (NSUInteger)atomic_load_explicit(&_orderingHitCount, memory_order_relaxed);
+}
+
+- (void)decayOrderingHitCount
+{
+    // hits recorded between the load and the store are lost, which only makes the count a little less precise
+    uint64_t hitCount = atomic_load_explicit(&_orderingHitCount, memory_order_relaxed);
+    atomic_store_explicit(&_orderingHitCount, hitCount / 2, memory_order_relaxed);
 }
 
 #pragma mark - NSCopying
@@ -252,6 +909,7 @@
 - (id)copyWithZone:(NSZone *)zone
 {
     JLRRouteDefinition *copy = [[[self class] alloc] initWithPattern:self.pattern priority:self.priority handlerBlock:self.handlerBlock];
+    copy.asyncHandlerBlock = self.asyncHandlerBlock;
     copy.scheme = self.scheme;
     return copy;
 }
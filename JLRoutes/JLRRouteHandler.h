@@ -68,6 +68,68 @@ NS_ASSUME_NONNULL_BEGIN
 
 + (BOOL (^__nonnull)(NSDictionary<NSString *, id> *parameters))handlerBlockForTargetClass:(Class)targetClass completion:(BOOL (^)(id <JLRRouteHandlerTarget> createdObject))completionHandler;
 
+
+/**
+ Creates and returns an asynchronous handler block that calls handleRouteWithParameters:completion: on a weak target object.
+ 
+ The block returned from this method should be passed as the handler block of an addRoute:priority:asyncHandler: call.
+ 
+ @param weakTarget The target object that should handle a matched route.
+ 
+ @returns A new asynchronous handler block for the provided weakTarget.
+ 
+ @discussion Only a weak pointer to the target object is captured in the block. If the object is deallocated, the route is treated as not handled.
+ */
+
++ (void (^__nonnull)(NSDictionary<NSString *, id> *parameters, void (^completion)(BOOL handled)))asyncHandlerBlockForWeakTarget:(__weak id <JLRRouteHandlerTarget>)weakTarget;
+
+
+///-------------------------------
+/// @name Reusing Targets
+///-------------------------------
+
+
+/**
+ Creates and returns a block like handlerBlockForTargetClass:completion:, except that it reuses targets that were handed back with recycleTarget:
+ instead of creating a new one every time, which is useful for targets that are expensive to create.
+ 
+ A reused target is sent prepareForReuseWithRouteParameters: with the new parameters, so targetClass must implement it as well as initWithRouteParameters:.
+ 
+ @param targetClass The target class to create or reuse for handling the route request. Must conform to JLRRouteHandlerTarget.
+ @param maximumPoolSize The most idle targets of targetClass that are kept around for reuse. Targets recycled past this are released.
+ @param completionHandler The completion block to call with the created or reused targetClass instance.
+ 
+ @returns A new handler block for creating or reusing instances of targetClass.
+ 
+ @discussion As with handlerBlockForTargetClass:completion:, the calling application owns the target it is handed. Once it's done with the target, it
+ should pass it to recycleTarget: so that a later route can reuse it. If completionHandler returns NO, the target is recycled right away.
+ */
+
++ (BOOL (^__nonnull)(NSDictionary<NSString *, id> *parameters))handlerBlockForPooledTargetClass:(Class)targetClass maximumPoolSize:(NSUInteger)maximumPoolSize completion:(BOOL (^)(id <JLRRouteHandlerTarget> target))completionHandler;
+
+
+/**
+ Hands a target created by a handlerBlockForPooledTargetClass:maximumPoolSize:completion: block back, so that it can be reused.
+ 
+ @param target The target the application is done with. It must not be used again until a handler block hands it out again.
+ */
+
++ (void)recycleTarget:(id <JLRRouteHandlerTarget>)target;
+
+
+/**
+ Creates idle targets of a pooled target class ahead of time on a background queue, so that the first routes don't pay for creating them.
+ 
+ @param targetClass A class that has been passed to handlerBlockForPooledTargetClass:maximumPoolSize:completion:.
+ @param count The number of targets to create. No more are created than fit in the class's pool.
+ @param completion An optional block called on the background queue once the targets have been created.
+ 
+ @discussion Prewarmed targets are created with initWithRouteParameters: and empty parameters, and always get prepareForReuseWithRouteParameters: before they are
+ handed out. Only prewarm classes that are safe to create off the main thread.
+ */
+
++ (void)prewarmTargetsOfClass:(Class)targetClass count:(NSUInteger)count completion:(nullable void (^)(void))completion;
+
 @end
 
 
@@ -100,6 +162,25 @@ NS_ASSUME_NONNULL_BEGIN
 
 - (BOOL)handleRouteWithParameters:(NSDictionary<NSString *, id> *)parameters;
 
+
+/**
+ Called for a successful route match, for targets that need to do asynchronous work before knowing if they handled the route.
+ 
+ @param parameters The match parameters passed to the handler block.
+ @param completion The block to call exactly once, on any thread, with YES if the route was handled and NO if matching a different route should be attempted.
+ */
+
+- (void)handleRouteWithParameters:(NSDictionary<NSString *, id> *)parameters completion:(void (^)(BOOL handled))completion;
+
+
+/**
+ Called before a recycled target is reused for another route, in place of initWithRouteParameters:.
+ 
+ @param parameters The match parameters of the new route. Anything left over from the previous route should be reset.
+ */
+
+- (void)prepareForReuseWithRouteParameters:(NSDictionary<NSString *, id> *)parameters;
+
 @end
 
 
@@ -13,8 +13,41 @@
 #import "JLRRouteHandler.h"
 
 
+// The idle targets of one pooled target class.
+@interface JLRRouteHandlerTargetPool : NSObject
+
+@property (nonatomic, assign) NSUInteger maximumSize;
+@property (nonatomic, strong) NSMutableArray <id <JLRRouteHandlerTarget>> *idleTargets;
+
+@end
+
+
+@implementation JLRRouteHandlerTargetPool
+
+- (instancetype)init
+{
+    if ((self = [super init])) {
+        self.idleTargets = [NSMutableArray array];
+    }
+    return self;
+}
+
+@end
+
+
+// target pools keyed by target class, only accessed while synchronized on this dictionary
+static NSMutableDictionary <id <NSCopying>, JLRRouteHandlerTargetPool *> *JLRRouteHandlerTargetPools = nil;
+
+
 @implementation JLRRouteHandler
 
++ (void)initialize
+{
+    if (self == [JLRRouteHandler class]) {
+        JLRRouteHandlerTargetPools = [NSMutableDictionary dictionary];
+    }
+}
+
 + (BOOL (^)(NSDictionary<NSString *, id> *parameters))handlerBlockForWeakTarget:(__weak id <JLRRouteHandlerTarget>)weakTarget
 {
     NSParameterAssert([weakTarget respondsToSelector:@selector(handleRouteWithParameters:)]);
@@ -36,4 +69,112 @@
     };
 }
 
++ (void (^)(NSDictionary<NSString *, id> *parameters, void (^completion)(BOOL handled)))asyncHandlerBlockForWeakTarget:(__weak id <JLRRouteHandlerTarget>)weakTarget
+{
+    NSParameterAssert([weakTarget respondsToSelector:@selector(handleRouteWithParameters:completion:)]);
+    
+    return ^(NSDictionary<NSString *, id> *parameters, void (^completion)(BOOL handled)) {
+        id <JLRRouteHandlerTarget> target = weakTarget;
+        
+        if (target == nil) {
+            completion(NO);
+        } else {
+            [target handleRouteWithParameters:parameters completion:completion];
+        }
+    };
+}
+
+#pragma mark - Reusing Targets
+
++ (BOOL (^)(NSDictionary<NSString *, id> *parameters))handlerBlockForPooledTargetClass:(Class)targetClass maximumPoolSize:(NSUInteger)maximumPoolSize completion:(BOOL (^)(id <JLRRouteHandlerTarget> target))completionHandler
+{
+    NSParameterAssert([targetClass conformsToProtocol:@protocol(JLRRouteHandlerTarget)]);
+    NSParameterAssert([targetClass instancesRespondToSelector:@selector(initWithRouteParameters:)]);
+    NSParameterAssert([targetClass instancesRespondToSelector:@selector(prepareForReuseWithRouteParameters:)]);
+    NSParameterAssert(completionHandler != nil);
+    
+    @synchronized (JLRRouteHandlerTargetPools) {
+        JLRRouteHandlerTargetPool *pool = [self _poolForTargetClass:targetClass createIfNeeded:YES];
+        pool.maximumSize = MAX(pool.maximumSize, maximumPoolSize);
+    }
+    
+    return ^BOOL(NSDictionary<NSString *, id> *parameters) {
+        id <JLRRouteHandlerTarget> target = [self _dequeueIdleTargetOfClass:targetClass];
+        
+        if (target != nil) {
+            [target prepareForReuseWithRouteParameters:parameters];
+        } else {
+            target = [[targetClass alloc] initWithRouteParameters:parameters];
+        }
+        
+        BOOL handled = completionHandler(target);
+        if (!handled) {
+            [self recycleTarget:target];
+        }
+        return handled;
+    };
+}
+
++ (void)recycleTarget:(id <JLRRouteHandlerTarget>)target
+{
+    NSParameterAssert(target != nil);
+    
+    @synchronized (JLRRouteHandlerTargetPools) {
+        JLRRouteHandlerTargetPool *pool = [self _poolForTargetClass:[target class] createIfNeeded:NO];
+        
+        if (pool.idleTargets.count < pool.maximumSize && [pool.idleTargets indexOfObjectIdenticalTo:target] == NSNotFound) {
+            [pool.idleTargets addObject:target];
+        }
+    }
+}
+
++ (void)prewarmTargetsOfClass:(Class)targetClass count:(NSUInteger)count completion:(void (^)(void))completion
+{
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_BACKGROUND, 0), ^{
+        NSUInteger createCount = 0;
+        @synchronized (JLRRouteHandlerTargetPools) {
+            JLRRouteHandlerTargetPool *pool = [self _poolForTargetClass:targetClass createIfNeeded:NO];
+            NSAssert(pool != nil, @"%@ has not been used as a pooled target class", targetClass);
+            
+            if (pool.maximumSize > pool.idleTargets.count) {
+                createCount = MIN(count, pool.maximumSize - pool.idleTargets.count);
+            }
+        }
+        
+        // targets are created outside of the lock, since creating them is what's slow
+        for (NSUInteger index = 0; index < createCount; index++) {
+            [self recycleTarget:[[targetClass alloc] initWithRouteParameters:@{}]];
+        }
+        
+        if (completion != nil) {
+            completion();
+        }
+    });
+}
+
++ (nullable id <JLRRouteHandlerTarget>)_dequeueIdleTargetOfClass:(Class)targetClass
+{
+    @synchronized (JLRRouteHandlerTargetPools) {
+        JLRRouteHandlerTargetPool *pool = [self _poolForTargetClass:targetClass createIfNeeded:NO];
+        id <JLRRouteHandlerTarget> target = [pool.idleTargets lastObject];
+        
+        if (target != nil) {
+            [pool.idleTargets removeLastObject];
+        }
+        return target;
+    }
+}
+
++ (nullable JLRRouteHandlerTargetPool *)_poolForTargetClass:(Class)targetClass createIfNeeded:(BOOL)createIfNeeded
+{
+    // must be called while synchronized on JLRRouteHandlerTargetPools
+    JLRRouteHandlerTargetPool *pool = JLRRouteHandlerTargetPools[(id <NSCopying>)targetClass];
+    
+    if (pool == nil && createIfNeeded) {
+        pool = [[JLRRouteHandlerTargetPool alloc] init];
+        JLRRouteHandlerTargetPools[(id <NSCopying>)targetClass] = pool;
+    }
+    return pool;
+}
+
 @end
@@ -0,0 +1,71 @@
+/*
+ Copyright (c) 2017, Joel Levin
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ 
+ Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ Neither the name of JLRoutes nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import <Foundation/Foundation.h>
+
+@class JLRRouteDefinition;
+@class JLRRouteRequest;
+
+NS_ASSUME_NONNULL_BEGIN
+
+
+/**
+ JLRRouteIndex is an immutable, segment-keyed trie over the pattern path components of a list of route definitions.
+ 
+ Static components become exact edges, ':variable' components share a single parameter edge, and a '*' component
+ terminates the pattern as a wildcard. Patterns with optional
+ groups are indexed by the components before their first group, since the groups shift everything after them. Looking up a request only visits the branches that could possibly match it,
+ and returns the candidate definitions in the same order they appear in the route list the index was built from.
+ 
+ Definitions that override -routeResponseForRequest: or -routeVariablesForRequest: cannot be indexed by their
+ pattern. Their -matchConstraints are indexed instead: the literal prefix like static components, and the rest checked
+ against each request that gets that far. Ones without constraints are always returned as candidates.
+ 
+ Each index also keeps a JLRRoutePrefilter over the same routes, so that requests that can't match any of them are
+ turned away without walking the trie.
+ 
+ Since an index is never mutated after it is created, it can be read from any thread without locking.
+ */
+
+@interface JLRRouteIndex : NSObject
+
+/// Creates an index over routes, which must already be in the order they should be tried in.
+- (instancetype)initWithRoutes:(NSArray <JLRRouteDefinition *> *)routes;
+
+/// Creates an index over routes that never returns any of excludedRoutes as candidates. They are still included in routes.
+- (instancetype)initWithRoutes:(NSArray <JLRRouteDefinition *> *)routes excludedRoutes:(nullable NSHashTable <JLRRouteDefinition *> *)excludedRoutes NS_DESIGNATED_INITIALIZER;
+
+/// Unavailable, use initWithRoutes: instead.
+- (instancetype)init NS_UNAVAILABLE;
+
+/// Unavailable, use initWithRoutes: instead.
++ (instancetype)new NS_UNAVAILABLE;
+
+/// The routes the index was built from.
+@property (nonatomic, copy, readonly) NSArray <JLRRouteDefinition *> *routes;
+
+/// Returns the definitions that may match request, in the same relative order as routes.
+- (NSArray <JLRRouteDefinition *> *)candidateRoutesForRequest:(JLRRouteRequest *)request;
+
+/// YES if the candidates for a request may depend on its scheme or host, and not only on its path components.
+@property (nonatomic, assign, readonly) BOOL constrainsSchemesOrHosts;
+
+/// Returns NO if candidateRoutesForRequest: would certainly return no routes for request. Only compares the bytes of its path components.
+- (BOOL)mayMatchRequest:(JLRRouteRequest *)request;
+
+/// Returns YES if whether route matches a request depends only on its pattern and the request's path components.
++ (BOOL)canIndexRoute:(JLRRouteDefinition *)route;
+
+@end
+
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,275 @@
+/*
+ Copyright (c) 2017, Joel Levin
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ 
+ Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ Neither the name of JLRoutes nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import "JLRRouteIndex.h"
+#import "JLRRouteDefinition.h"
+#import "JLRRouteRequest.h"
+#import "JLRRoutePrefilter.h"
+
+
+@interface JLRRouteIndexEntry : NSObject
+
+@property (nonatomic, strong) JLRRouteDefinition *route;
+@property (nonatomic, assign) NSUInteger sequence;
+@property (nonatomic, strong) JLRRouteMatchConstraints *constraints;
+
+@end
+
+
+@implementation JLRRouteIndexEntry
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"<%@ %p> - %@ (sequence: %@)", NSStringFromClass([self class]), self, self.route, @(self.sequence)];
+}
+
+@end
+
+
+#pragma mark -
+
+
+@interface JLRRouteIndexNode : NSObject
+
+@property (nonatomic, strong) NSMutableDictionary <NSString *, JLRRouteIndexNode *> *staticChildren;
+@property (nonatomic, strong) JLRRouteIndexNode *variableChild;
+@property (nonatomic, strong) NSMutableArray <JLRRouteIndexEntry *> *terminalEntries;
+@property (nonatomic, strong) NSMutableArray <JLRRouteIndexEntry *> *wildcardEntries;
+@property (nonatomic, strong) NSMutableArray <JLRRouteIndexEntry *> *constrainedEntries;
+
+- (JLRRouteIndexNode *)childNodeForPatternComponent:(NSString *)component;
+- (JLRRouteIndexNode *)childNodeForLiteralComponent:(NSString *)component;
+
+@end
+
+
+@implementation JLRRouteIndexNode
+
+- (JLRRouteIndexNode *)childNodeForPatternComponent:(NSString *)component
+{
+    if ([component hasPrefix:@":"]) {
+        // all variables at the same depth match the same URL components, so they share one edge
+        if (self.variableChild == nil) {
+            self.variableChild = [[JLRRouteIndexNode alloc] init];
+        }
+        return self.variableChild;
+    }
+    
+    return [self childNodeForLiteralComponent:component];
+}
+
+- (JLRRouteIndexNode *)childNodeForLiteralComponent:(NSString *)component
+{
+    JLRRouteIndexNode *child = self.staticChildren[component];
+    if (child == nil) {
+        if (self.staticChildren == nil) {
+            self.staticChildren = [NSMutableDictionary dictionary];
+        }
+        child = [[JLRRouteIndexNode alloc] init];
+        self.staticChildren[component] = child;
+    }
+    return child;
+}
+
+@end
+
+
+#pragma mark -
+
+
+@interface JLRRouteIndex ()
+
+@property (nonatomic, copy) NSArray <JLRRouteDefinition *> *routes;
+@property (nonatomic, strong) JLRRouteIndexNode *rootNode;
+@property (nonatomic, strong) JLRRoutePrefilter *prefilter;
+@property (nonatomic, assign) BOOL constrainsSchemesOrHosts;
+
+@end
+
+
+@implementation JLRRouteIndex
+
+- (instancetype)initWithRoutes:(NSArray <JLRRouteDefinition *> *)routes
+{
+    return [self initWithRoutes:routes excludedRoutes:nil];
+}
+
+- (instancetype)initWithRoutes:(NSArray <JLRRouteDefinition *> *)routes excludedRoutes:(NSHashTable <JLRRouteDefinition *> *)excludedRoutes
+{
+    if ((self = [super init])) {
+        self.routes = routes;
+        self.rootNode = [[JLRRouteIndexNode alloc] init];
+        
+        NSMutableArray <JLRRouteDefinition *> *indexedRoutes = [NSMutableArray arrayWithCapacity:routes.count];
+        NSUInteger sequence = 0;
+        
+        for (JLRRouteDefinition *route in self.routes) {
+            if ([excludedRoutes containsObject:route]) {
+                sequence++;
+                continue;
+            }
+            
+            JLRRouteIndexEntry *entry = [[JLRRouteIndexEntry alloc] init];
+            entry.route = route;
+            entry.sequence = sequence++;
+            [self _addEntry:entry];
+            [indexedRoutes addObject:route];
+        }
+        
+        self.prefilter = [[JLRRoutePrefilter alloc] initWithRoutes:indexedRoutes];
+    }
+    return self;
+}
+
+- (NSArray <JLRRouteDefinition *> *)candidateRoutesForRequest:(JLRRouteRequest *)request
+{
+    NSMutableArray <JLRRouteIndexEntry *> *entries = [NSMutableArray array];
+    [self _collectEntriesFromNode:self.rootNode request:request pathComponents:request.pathComponents depth:0 intoArray:entries];
+    
+    if (entries.count > 1) {
+        // restore the order a linear scan of the route list would have produced
+        [entries sortUsingComparator:^NSComparisonResult(JLRRouteIndexEntry *entry1, JLRRouteIndexEntry *entry2) {
+            if (entry1.sequence != entry2.sequence) {
+                return entry1.sequence < entry2.sequence ? NSOrderedAscending : NSOrderedDescending;
+            }
+            return NSOrderedSame;
+        }];
+    }
+    
+    NSMutableArray <JLRRouteDefinition *> *candidates = [NSMutableArray arrayWithCapacity:entries.count];
+    for (JLRRouteIndexEntry *entry in entries) {
+        [candidates addObject:entry.route];
+    }
+    
+    return [candidates copy];
+}
+
+- (BOOL)mayMatchRequest:(JLRRouteRequest *)request
+{
+    return [self.prefilter mayMatchRequest:request];
+}
+
++ (BOOL)canIndexRoute:(JLRRouteDefinition *)route
+{
+    Class routeClass = [route class];
+    if (routeClass == [JLRRouteDefinition class]) {
+        return YES;
+    }
+    
+    // subclasses are only indexable if they kept the default pattern matching behavior
+    SEL matchingSelectors[] = {@selector(routeResponseForRequest:), @selector(routeVariablesForRequest:)};
+    for (NSUInteger i = 0; i < sizeof(matchingSelectors) / sizeof(matchingSelectors[0]); i++) {
+        if ([routeClass instanceMethodForSelector:matchingSelectors[i]] != [JLRRouteDefinition instanceMethodForSelector:matchingSelectors[i]]) {
+            return NO;
+        }
+    }
+    
+    return YES;
+}
+
+#pragma mark - Private
+
+- (void)_addEntry:(JLRRouteIndexEntry *)entry
+{
+    if (![[self class] canIndexRoute:entry.route]) {
+        [self _addCustomEntry:entry];
+        return;
+    }
+    
+    JLRRouteIndexNode *node = self.rootNode;
+    NSArray <NSString *> *patternPathComponents = entry.route.patternPathComponents;
+    NSUInteger leadingRequiredPathComponentCount = entry.route.leadingRequiredPathComponentCount;
+    
+    for (NSUInteger index = 0; index < patternPathComponents.count; index++) {
+        NSString *component = patternPathComponents[index];
+        
+        if ([component isEqualToString:@"*"] || index == leadingRequiredPathComponentCount) {
+            // wildcards match everything from this depth on, so nothing past them needs to be indexed. Optional groups
+            // shift everything after them, so those patterns are only indexed by the components before the first group.
+            [self _addWildcardEntry:entry toNode:node];
+            return;
+        }
+        node = [node childNodeForPatternComponent:component];
+    }
+    
+    if (node.terminalEntries == nil) {
+        node.terminalEntries = [NSMutableArray array];
+    }
+    [node.terminalEntries addObject:entry];
+}
+
+- (void)_addCustomEntry:(JLRRouteIndexEntry *)entry
+{
+    entry.constraints = [[entry.route matchConstraints] copy];
+    
+    if (entry.constraints == nil) {
+        // custom matching logic without any constraints, so it has to be considered for every request
+        [self _addWildcardEntry:entry toNode:self.rootNode];
+        return;
+    }
+    
+    if (entry.constraints.schemes != nil || entry.constraints.hosts != nil) {
+        self.constrainsSchemesOrHosts = YES;
+    }
+    
+    // the literal prefix is indexed like the static components of a pattern, and the rest is checked per request
+    JLRRouteIndexNode *node = self.rootNode;
+    for (NSString *component in entry.constraints.literalPrefix) {
+        node = [node childNodeForLiteralComponent:component];
+    }
+    
+    if (node.constrainedEntries == nil) {
+        node.constrainedEntries = [NSMutableArray array];
+    }
+    [node.constrainedEntries addObject:entry];
+}
+
+- (void)_addWildcardEntry:(JLRRouteIndexEntry *)entry toNode:(JLRRouteIndexNode *)node
+{
+    if (node.wildcardEntries == nil) {
+        node.wildcardEntries = [NSMutableArray array];
+    }
+    [node.wildcardEntries addObject:entry];
+}
+
+- (void)_collectEntriesFromNode:(JLRRouteIndexNode *)node request:(JLRRouteRequest *)request pathComponents:(NSArray <NSString *> *)pathComponents depth:(NSUInteger)depth intoArray:(NSMutableArray <JLRRouteIndexEntry *> *)entries
+{
+    if (node.wildcardEntries != nil) {
+        // match: /a/b/c/* has to be matched by at least /a/b/c
+        [entries addObjectsFromArray:node.wildcardEntries];
+    }
+    
+    for (JLRRouteIndexEntry *entry in node.constrainedEntries) {
+        // custom definitions whose literal prefix got this far, which are only candidates if the rest of their constraints allow it
+        if ([entry.constraints allowsRequest:request]) {
+            [entries addObject:entry];
+        }
+    }
+    
+    if (depth == pathComponents.count) {
+        if (node.terminalEntries != nil) {
+            [entries addObjectsFromArray:node.terminalEntries];
+        }
+        return;
+    }
+    
+    JLRRouteIndexNode *staticChild = node.staticChildren[pathComponents[depth]];
+    if (staticChild != nil) {
+        [self _collectEntriesFromNode:staticChild request:request pathComponents:pathComponents depth:depth + 1 intoArray:entries];
+    }
+    
+    if (node.variableChild != nil) {
+        [self _collectEntriesFromNode:node.variableChild request:request pathComponents:pathComponents depth:depth + 1 intoArray:entries];
+    }
+}
+
+@end
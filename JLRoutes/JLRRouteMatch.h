@@ -0,0 +1,76 @@
+/*
+ Copyright (c) 2017, Joel Levin
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ 
+ Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ Neither the name of JLRoutes nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import <Foundation/Foundation.h>
+
+@class JLRoutes;
+@class JLRRouteDefinition;
+@class JLRRouteRequest;
+
+NS_ASSUME_NONNULL_BEGIN
+
+
+/**
+ JLRRouteMatch is the immutable result of matching a URL against the routes of a scheme, ahead of routing it.
+ 
+ It holds every route that matched, in the order they will be tried, along with the match parameters for each. Routing the
+ match with +[JLRoutes routeMatch:] calls their handler blocks without parsing or matching the URL again, with the same
+ behavior as +[JLRoutes routeURL:] (a handler returning NO moves on to the next route, then to the global routes if the scheme
+ falls back to them, then to the unmatchedURLHandler).
+ */
+
+@interface JLRRouteMatch : NSObject
+
+/// The routes controller (scheme) that the URL was matched against.
+@property (nonatomic, strong, readonly) JLRoutes *routesController;
+
+/// The parsed request that was matched.
+@property (nonatomic, strong, readonly) JLRRouteRequest *request;
+
+/// The URL that was matched.
+@property (nonatomic, strong, readonly) NSURL *URL;
+
+/// The routes that matched, in the order they will be tried.
+@property (nonatomic, copy, readonly) NSArray <JLRRouteDefinition *> *routes;
+
+/// The match parameters for each of routes, in the same order.
+@property (nonatomic, copy, readonly) NSArray <NSDictionary <NSString *, id> *> *parameters;
+
+/// The result of matching the same request against the global routes, if routesController falls back to them. It is computed the first time it is needed.
+@property (nonatomic, strong, readonly, nullable) JLRRouteMatch *globalRoutesMatch;
+
+/// Returns YES if any route matched, either in routesController or in the global routes it falls back to.
+@property (nonatomic, assign, readonly) BOOL canRoute;
+
+/**
+ Creates a new match. This is the designated initializer.
+ 
+ @param routesController The routes controller that request was matched against.
+ @param request The parsed request.
+ @param routes The matching routes, in the order they will be tried.
+ @param parameters The match parameters for each of routes.
+ @param globalRoutesMatchProvider Returns the match against the global routes, or nil if routesController doesn't fall back to them.
+ 
+ @returns The newly initialized match.
+ */
+- (instancetype)initWithRoutesController:(JLRoutes *)routesController request:(JLRRouteRequest *)request routes:(NSArray <JLRRouteDefinition *> *)routes parameters:(NSArray <NSDictionary <NSString *, id> *> *)parameters globalRoutesMatchProvider:(nullable JLRRouteMatch * (^)(void))globalRoutesMatchProvider NS_DESIGNATED_INITIALIZER;
+
+/// Unavailable, use +[JLRoutes matchURL:] instead.
+- (instancetype)init NS_UNAVAILABLE;
+
+/// Unavailable, use +[JLRoutes matchURL:] instead.
++ (instancetype)new NS_UNAVAILABLE;
+
+@end
+
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,64 @@
+/*
+ Copyright (c) 2017, Joel Levin
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ 
+ Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ Neither the name of JLRoutes nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import "JLRRouteMatch.h"
+#import "JLRRouteRequest.h"
+
+
+@implementation JLRRouteMatch
+{
+    JLRRouteMatch * (^_globalRoutesMatchProvider)(void);
+    JLRRouteMatch *_globalRoutesMatch;
+}
+
+- (instancetype)initWithRoutesController:(JLRoutes *)routesController request:(JLRRouteRequest *)request routes:(NSArray <JLRRouteDefinition *> *)routes parameters:(NSArray <NSDictionary <NSString *, id> *> *)parameters globalRoutesMatchProvider:(JLRRouteMatch * (^)(void))globalRoutesMatchProvider
+{
+    NSParameterAssert(routes.count == parameters.count);
+    
+    if ((self = [super init])) {
+        _routesController = routesController;
+        _request = request;
+        _routes = [routes copy];
+        _parameters = [parameters copy];
+        _globalRoutesMatchProvider = [globalRoutesMatchProvider copy];
+    }
+    return self;
+}
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"<%@ %p> - URL: %@, routes: %@", NSStringFromClass([self class]), self, self.URL, self.routes];
+}
+
+- (NSURL *)URL
+{
+    return self.request.URL;
+}
+
+- (JLRRouteMatch *)globalRoutesMatch
+{
+    @synchronized (self) {
+        if (_globalRoutesMatchProvider != nil) {
+            // the global routes are only matched if something asks for them, which is usually only when no route here matched
+            _globalRoutesMatch = _globalRoutesMatchProvider();
+            _globalRoutesMatchProvider = nil;
+        }
+        return _globalRoutesMatch;
+    }
+}
+
+- (BOOL)canRoute
+{
+    return self.routes.count > 0 || self.globalRoutesMatch.canRoute;
+}
+
+@end
@@ -0,0 +1,51 @@
+/*
+ Copyright (c) 2017, Joel Levin
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ 
+ Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ Neither the name of JLRoutes nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import <Foundation/Foundation.h>
+
+@class JLRRouteRequest;
+
+NS_ASSUME_NONNULL_BEGIN
+
+
+/**
+ JLRRouteMatchConstraints describes which requests a route definition could possibly match.
+ 
+ JLRRouteDefinition subclasses that override -routeResponseForRequest: or -routeVariablesForRequest: return these from
+ -matchConstraints, so that the route index can skip them for requests they could never match instead of asking them
+ about every request. A constraint that isn't set doesn't rule anything out.
+ */
+
+@interface JLRRouteMatchConstraints : NSObject <NSCopying>
+
+/// The leading path components every matching request has, as they appear in the URL (before removing percent encoding). Defaults to an empty array.
+@property (nonatomic, copy) NSArray <NSString *> *literalPrefix;
+
+/// The fewest path components a matching request has. Defaults to 0. The literal prefix also implies a minimum.
+@property (nonatomic, assign) NSUInteger minimumPathComponentCount;
+
+/// The most path components a matching request has. Defaults to NSUIntegerMax.
+@property (nonatomic, assign) NSUInteger maximumPathComponentCount;
+
+/// The URL schemes of matching requests, compared case insensitively, or nil for any scheme. Only useful for global routes, which see URLs of every scheme.
+@property (nonatomic, copy, nullable) NSSet <NSString *> *schemes;
+
+/// The URL hosts of matching requests, compared case insensitively, or nil for any host.
+@property (nonatomic, copy, nullable) NSSet <NSString *> *hosts;
+
+/// Returns YES if request satisfies the constraints. Checking the literal prefix is left to the route index.
+- (BOOL)allowsRequest:(JLRRouteRequest *)request;
+
+@end
+
+
+NS_ASSUME_NONNULL_END
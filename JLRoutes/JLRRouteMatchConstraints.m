@@ -0,0 +1,94 @@
+/*
+ Copyright (c) 2017, Joel Levin
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ 
+ Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ Neither the name of JLRoutes nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import "JLRRouteMatchConstraints.h"
+#import "JLRRouteRequest.h"
+
+
+@implementation JLRRouteMatchConstraints
+{
+    NSSet <NSString *> *_lowercaseSchemes;
+    NSSet <NSString *> *_lowercaseHosts;
+}
+
+- (instancetype)init
+{
+    if ((self = [super init])) {
+        _literalPrefix = @[];
+        _maximumPathComponentCount = NSUIntegerMax;
+    }
+    return self;
+}
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"<%@ %p> - prefix: /%@, path components: %@-%@, schemes: %@, hosts: %@", NSStringFromClass([self class]), self, [self.literalPrefix componentsJoinedByString:@"/"], @(self.minimumPathComponentCount), self.maximumPathComponentCount == NSUIntegerMax ? @"*" : @(self.maximumPathComponentCount), self.schemes ?: @"*", self.hosts ?: @"*"];
+}
+
+- (void)setSchemes:(NSSet <NSString *> *)schemes
+{
+    _schemes = [schemes copy];
+    _lowercaseSchemes = [[self class] _lowercaseStringsFromSet:schemes];
+}
+
+- (void)setHosts:(NSSet <NSString *> *)hosts
+{
+    _hosts = [hosts copy];
+    _lowercaseHosts = [[self class] _lowercaseStringsFromSet:hosts];
+}
+
+- (BOOL)allowsRequest:(JLRRouteRequest *)request
+{
+    NSUInteger pathComponentCount = request.pathComponentCount;
+    
+    if (pathComponentCount < MAX(self.minimumPathComponentCount, self.literalPrefix.count) || pathComponentCount > self.maximumPathComponentCount) {
+        return NO;
+    }
+    
+    if (_lowercaseSchemes != nil && ![_lowercaseSchemes containsObject:[request.URL.scheme lowercaseString] ?: @""]) {
+        return NO;
+    }
+    
+    if (_lowercaseHosts != nil && ![_lowercaseHosts containsObject:[request.URL.host lowercaseString] ?: @""]) {
+        return NO;
+    }
+    
+    return YES;
+}
+
++ (NSSet <NSString *> *)_lowercaseStringsFromSet:(NSSet <NSString *> *)strings
+{
+    if (strings == nil) {
+        return nil;
+    }
+    
+    NSMutableSet <NSString *> *lowercaseStrings = [NSMutableSet setWithCapacity:strings.count];
+    for (NSString *string in strings) {
+        [lowercaseStrings addObject:[string lowercaseString]];
+    }
+    return [lowercaseStrings copy];
+}
+
+#pragma mark - NSCopying
+
+- (id)copyWithZone:(NSZone *)zone
+{
+    JLRRouteMatchConstraints *copy = [[[self class] alloc] init];
+    copy.literalPrefix = self.literalPrefix;
+    copy.minimumPathComponentCount = self.minimumPathComponentCount;
+    copy.maximumPathComponentCount = self.maximumPathComponentCount;
+    copy.schemes = self.schemes;
+    copy.hosts = self.hosts;
+    return copy;
+}
+
+@end
@@ -0,0 +1,145 @@
+/*
+ Copyright (c) 2017, Joel Levin
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ 
+ Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ Neither the name of JLRoutes nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import <Foundation/Foundation.h>
+
+@class JLRoutes;
+@class JLRRouteDefinition;
+
+NS_ASSUME_NONNULL_BEGIN
+
+
+/// The number of buckets in JLRRouteMetrics.matchLatencyHistogram.
+enum {
+    JLRRouteMatchLatencyBucketCount = 32
+};
+
+
+/// Events reported to a JLRRouteTraceSink while routing.
+typedef NS_ENUM(NSUInteger, JLRRouteTraceEvent) {
+    /// A URL is about to be matched against the routes.
+    JLRRouteTraceEventWillRouteURL,
+    
+    /// A route matched the URL. The route and its match parameters are provided.
+    JLRRouteTraceEventDidMatchRoute,
+    
+    /// The handler block of a matching route returned NO, so routing continues with the next matching route.
+    JLRRouteTraceEventHandlerDidDecline,
+    
+    /// No route matched the URL, or every matching route declined it.
+    JLRRouteTraceEventDidNotRouteURL,
+    
+    /// The URL is about to be routed by the global routes, because shouldFallbackToGlobalRoutes is set.
+    JLRRouteTraceEventWillFallBackToGlobalRoutes,
+    
+    /// The unmatchedURLHandler is about to be called.
+    JLRRouteTraceEventWillCallUnmatchedURLHandler
+};
+
+
+/**
+ A trace sink receives an event for each step JLRoutes takes while routing a URL.
+ 
+ Configure one with +[JLRoutes setTraceSink:]. When no trace sink is set (and verbose logging is disabled), tracing is skipped
+ entirely. Events can be delivered on any thread that routes URLs, so implementations must be thread safe.
+ */
+
+@protocol JLRRouteTraceSink <NSObject>
+
+/**
+ Called for each trace event.
+ 
+ @param routes The routes controller doing the routing.
+ @param event The event.
+ @param URL The URL being routed.
+ @param route The route the event is about, if any.
+ @param parameters The match parameters for route, if any.
+ */
+- (void)routes:(JLRoutes *)routes traceEvent:(JLRRouteTraceEvent)event URL:(nullable NSURL *)URL route:(nullable JLRRouteDefinition *)route parameters:(nullable NSDictionary *)parameters;
+
+@end
+
+
+/**
+ JLRRouteDefinitionMetrics is a snapshot of the counters for a single route definition.
+ */
+
+@interface JLRRouteDefinitionMetrics : NSObject
+
+/// The number of times the route was checked against a URL.
+@property (nonatomic, assign, readonly) NSUInteger matchAttemptCount;
+
+/// The number of times the route matched a URL.
+@property (nonatomic, assign, readonly) NSUInteger matchCount;
+
+/// The number of times the route's handler block returned YES.
+@property (nonatomic, assign, readonly) NSUInteger handledCount;
+
+/// The number of times the route's handler block returned NO.
+@property (nonatomic, assign, readonly) NSUInteger declinedCount;
+
+/// The total time spent in the route's handler block.
+@property (nonatomic, assign, readonly) NSTimeInterval handlerDuration;
+
+/// Creates a new snapshot.
+- (instancetype)initWithMatchAttemptCount:(NSUInteger)matchAttemptCount matchCount:(NSUInteger)matchCount handledCount:(NSUInteger)handledCount declinedCount:(NSUInteger)declinedCount handlerDuration:(NSTimeInterval)handlerDuration NS_DESIGNATED_INITIALIZER;
+
+/// Unavailable, use initWithMatchAttemptCount:matchCount:handledCount:declinedCount:handlerDuration: instead.
+- (instancetype)init NS_UNAVAILABLE;
+
+/// Unavailable, use initWithMatchAttemptCount:matchCount:handledCount:declinedCount:handlerDuration: instead.
++ (instancetype)new NS_UNAVAILABLE;
+
+@end
+
+
+/**
+ JLRRouteMetrics is a snapshot of the counters for a routes controller (scheme) and each of its routes.
+ */
+
+@interface JLRRouteMetrics : NSObject
+
+/// The scheme the metrics are for.
+@property (nonatomic, copy, readonly) NSString *scheme;
+
+/// The number of URLs routed (or checked with canRouteURL:).
+@property (nonatomic, assign, readonly) NSUInteger routingCount;
+
+/// The number of URLs that no route matched, or that every matching route's handler block declined.
+@property (nonatomic, assign, readonly) NSUInteger missCount;
+
+/// The number of times routing fell back to the global routes.
+@property (nonatomic, assign, readonly) NSUInteger globalFallbackCount;
+
+/// The number of times the unmatchedURLHandler was called.
+@property (nonatomic, assign, readonly) NSUInteger unmatchedURLHandlerCount;
+
+/// Counts of how long it took to parse each URL and find its first matching route (or find that none match), not including
+/// handler blocks. Bucket i counts latencies of at least 2^i and less than 2^(i+1) nanoseconds; the last bucket also counts anything longer.
+@property (nonatomic, copy, readonly) NSArray <NSNumber *> *matchLatencyHistogram;
+
+/// The metrics for each route, in the same order as -[JLRoutes routes].
+@property (nonatomic, copy, readonly) NSArray <JLRRouteDefinitionMetrics *> *routeMetrics;
+
+/// Creates a new snapshot.
+- (instancetype)initWithScheme:(NSString *)scheme routingCount:(NSUInteger)routingCount missCount:(NSUInteger)missCount globalFallbackCount:(NSUInteger)globalFallbackCount unmatchedURLHandlerCount:(NSUInteger)unmatchedURLHandlerCount matchLatencyHistogram:(NSArray <NSNumber *> *)matchLatencyHistogram routeMetrics:(NSArray <JLRRouteDefinitionMetrics *> *)routeMetrics NS_DESIGNATED_INITIALIZER;
+
+/// Unavailable, use initWithScheme:routingCount:missCount:globalFallbackCount:unmatchedURLHandlerCount:matchLatencyHistogram:routeMetrics: instead.
+- (instancetype)init NS_UNAVAILABLE;
+
+/// Unavailable, use initWithScheme:routingCount:missCount:globalFallbackCount:unmatchedURLHandlerCount:matchLatencyHistogram:routeMetrics: instead.
++ (instancetype)new NS_UNAVAILABLE;
+
+@end
+
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,59 @@
+/*
+ Copyright (c) 2017, Joel Levin
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ 
+ Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ Neither the name of JLRoutes nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import "JLRRouteMetrics.h"
+
+
+@implementation JLRRouteDefinitionMetrics
+
+- (instancetype)initWithMatchAttemptCount:(NSUInteger)matchAttemptCount matchCount:(NSUInteger)matchCount handledCount:(NSUInteger)handledCount declinedCount:(NSUInteger)declinedCount handlerDuration:(NSTimeInterval)handlerDuration
+{
+    if ((self = [super init])) {
+        _matchAttemptCount = matchAttemptCount;
+        _matchCount = matchCount;
+        _handledCount = handledCount;
+        _declinedCount = declinedCount;
+        _handlerDuration = handlerDuration;
+    }
+    return self;
+}
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"<%@ %p> - attempts: %lu, matches: %lu, handled: %lu, declined: %lu, handler duration: %f", NSStringFromClass([self class]), self, (unsigned long)self.matchAttemptCount, (unsigned long)self.matchCount, (unsigned long)self.handledCount, (unsigned long)self.declinedCount, self.handlerDuration];
+}
+
+@end
+
+
+@implementation JLRRouteMetrics
+
+- (instancetype)initWithScheme:(NSString *)scheme routingCount:(NSUInteger)routingCount missCount:(NSUInteger)missCount globalFallbackCount:(NSUInteger)globalFallbackCount unmatchedURLHandlerCount:(NSUInteger)unmatchedURLHandlerCount matchLatencyHistogram:(NSArray <NSNumber *> *)matchLatencyHistogram routeMetrics:(NSArray <JLRRouteDefinitionMetrics *> *)routeMetrics
+{
+    if ((self = [super init])) {
+        _scheme = [scheme copy];
+        _routingCount = routingCount;
+        _missCount = missCount;
+        _globalFallbackCount = globalFallbackCount;
+        _unmatchedURLHandlerCount = unmatchedURLHandlerCount;
+        _matchLatencyHistogram = [matchLatencyHistogram copy];
+        _routeMetrics = [routeMetrics copy];
+    }
+    return self;
+}
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"<%@ %p> - scheme: %@, routed: %lu, misses: %lu, global fallbacks: %lu, unmatched URL handler: %lu", NSStringFromClass([self class]), self, self.scheme, (unsigned long)self.routingCount, (unsigned long)self.missCount, (unsigned long)self.globalFallbackCount, (unsigned long)self.unmatchedURLHandlerCount];
+}
+
+@end
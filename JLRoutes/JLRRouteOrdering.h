@@ -0,0 +1,53 @@
+/*
+ Copyright (c) 2017, Joel Levin
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ 
+ Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ Neither the name of JLRoutes nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import <Foundation/Foundation.h>
+#import "JLRRouteDefinition.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+
+/**
+ JLRRouteOrdering moves routes that are used often ahead of the other routes with the same priority, without changing which
+ route any URL matches.
+ 
+ A route is only ever moved past routes that it can be proven never to match the same URLs as, so for every URL, the routes
+ it matches are still tried in the same order. Routes whose matching does not depend only on their pattern may match
+ anything, so they are never moved past and never move.
+ */
+
+@interface JLRRouteOrdering : NSObject
+
+/// Returns NO only if no URL can match both route and otherRoute.
++ (BOOL)route:(JLRRouteDefinition *)route mayMatchSameURLsAsRoute:(JLRRouteDefinition *)otherRoute;
+
+/// Returns routes, which must be ordered by descending priority, with each of routesToMove moved as far ahead of the routes with the same priority as it can be.
+/// routesToMove is ordered from the most to the least important, so when two of them can't pass each other, the more important one stays ahead.
++ (NSArray <JLRRouteDefinition *> *)routes:(NSArray <JLRRouteDefinition *> *)routes byMovingRoutesForward:(NSArray <JLRRouteDefinition *> *)routesToMove;
+
+@end
+
+
+// How often each route was the one handling a URL, used to decide which routes to move forward.
+@interface JLRRouteDefinition (JLRRouteOrdering)
+
+@property (nonatomic, assign, readonly) NSUInteger orderingHitCount;
+
+- (void)recordOrderingHit;
+
+// Halves the hit count, so that routes that are no longer used lose their place over time.
+- (void)decayOrderingHitCount;
+
+@end
+
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,99 @@
+/*
+ Copyright (c) 2017, Joel Levin
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ 
+ Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ Neither the name of JLRoutes nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import "JLRRouteOrdering.h"
+#import "JLRRouteIndex.h"
+#import "JLRRouteTable.h"
+
+
+// Returns NO only if no path can match both of two patterns, as given by -enumerateCompiledPatternsUsingBlock:.
+static BOOL JLRRouteOrderingPatternsMayOverlap(const JLRRouteSegment *segments, NSUInteger count, BOOL endsWithWildcard, const JLRRouteSegment *otherSegments, NSUInteger otherCount, BOOL otherEndsWithWildcard)
+{
+    // a pattern without a wildcard matches paths of exactly its length, and one with a wildcard matches paths at least as long,
+    // so the lengths only rule out an overlap when the shorter pattern has no wildcard
+    if ((!endsWithWildcard && count < otherCount) || (!otherEndsWithWildcard && otherCount < count)) {
+        return NO;
+    }
+    
+    for (NSUInteger index = 0; index < MIN(count, otherCount); index++) {
+        JLRRouteSegment segment = segments[index];
+        JLRRouteSegment otherSegment = otherSegments[index];
+        
+        if (segment.type == JLRRouteSegmentTypeLiteral && otherSegment.type == JLRRouteSegmentTypeLiteral && ![segment.value isEqualToString:otherSegment.value]) {
+            return NO;
+        }
+        
+        // a constrained variable can't match the same path component as a literal it doesn't accept
+        if ((segment.type == JLRRouteSegmentTypeLiteral && otherSegment.constraint != nil && ![otherSegment.constraint mayAllowValueOfLiteral:segment.value]) || (otherSegment.type == JLRRouteSegmentTypeLiteral && segment.constraint != nil && ![segment.constraint mayAllowValueOfLiteral:otherSegment.value])) {
+            return NO;
+        }
+    }
+    
+    return YES;
+}
+
+
+@implementation JLRRouteOrdering
+
++ (BOOL)route:(JLRRouteDefinition *)route mayMatchSameURLsAsRoute:(JLRRouteDefinition *)otherRoute
+{
+    if (![JLRRouteIndex canIndexRoute:route] || ![JLRRouteIndex canIndexRoute:otherRoute]) {
+        return YES;
+    }
+    
+    __block BOOL mayOverlap = NO;
+    
+    BOOL enumerated = [route enumerateCompiledPatternsUsingBlock:^(const JLRRouteSegment *segments, NSUInteger count, BOOL endsWithWildcard) {
+        if (mayOverlap) {
+            return;
+        }
+        
+        BOOL otherEnumerated = [otherRoute enumerateCompiledPatternsUsingBlock:^(const JLRRouteSegment *otherSegments, NSUInteger otherCount, BOOL otherEndsWithWildcard) {
+            if (!mayOverlap && JLRRouteOrderingPatternsMayOverlap(segments, count, endsWithWildcard, otherSegments, otherCount, otherEndsWithWildcard)) {
+                mayOverlap = YES;
+            }
+        }];
+        
+        if (!otherEnumerated) {
+            mayOverlap = YES;
+        }
+    }];
+    
+    return mayOverlap || !enumerated;
+}
+
++ (NSArray <JLRRouteDefinition *> *)routes:(NSArray <JLRRouteDefinition *> *)routes byMovingRoutesForward:(NSArray <JLRRouteDefinition *> *)routesToMove
+{
+    NSMutableArray <JLRRouteDefinition *> *orderedRoutes = [routes mutableCopy];
+    
+    // the most important route moves last, so it ends up ahead of any less important routes that it may pass
+    for (JLRRouteDefinition *route in [routesToMove reverseObjectEnumerator]) {
+        NSUInteger index = [orderedRoutes indexOfObjectIdenticalTo:route];
+        if (index == NSNotFound || ![JLRRouteIndex canIndexRoute:route]) {
+            continue;
+        }
+        
+        NSUInteger newIndex = index;
+        while (newIndex > 0 && orderedRoutes[newIndex - 1].priority == route.priority && ![self route:route mayMatchSameURLsAsRoute:orderedRoutes[newIndex - 1]]) {
+            newIndex--;
+        }
+        
+        if (newIndex != index) {
+            [orderedRoutes removeObjectAtIndex:index];
+            [orderedRoutes insertObject:route atIndex:newIndex];
+        }
+    }
+    
+    return [orderedRoutes copy];
+}
+
+@end
@@ -0,0 +1,50 @@
+/*
+ Copyright (c) 2017, Joel Levin
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ 
+ Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ Neither the name of JLRoutes nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import <Foundation/Foundation.h>
+
+@class JLRRouteDefinition;
+@class JLRRouteRequest;
+
+NS_ASSUME_NONNULL_BEGIN
+
+
+/**
+ JLRRoutePrefilter is an immutable summary of a list of route definitions, used to turn away requests that can't match any of them
+ before looking them up in the resolution cache or the route index.
+ 
+ It keeps which path component counts the routes accept (with a wildcard accepting every count from its depth on), split between
+ routes that start with static components and routes that start with a variable, and a Bloom filter over the static prefixes of
+ the former. It only ever compares the request's path components as raw bytes, without creating strings for them.
+ 
+ A request the prefilter rejects is never matched by any of the routes, so rejecting it is always exact. A request it accepts
+ may still not match anything.
+ */
+
+@interface JLRRoutePrefilter : NSObject
+
+/// Creates a prefilter for routes. Custom definitions without match constraints can match any request, so with one of them the prefilter accepts everything.
+- (instancetype)initWithRoutes:(NSArray <JLRRouteDefinition *> *)routes NS_DESIGNATED_INITIALIZER;
+
+/// Unavailable, use initWithRoutes: instead.
+- (instancetype)init NS_UNAVAILABLE;
+
+/// Unavailable, use initWithRoutes: instead.
++ (instancetype)new NS_UNAVAILABLE;
+
+/// Returns NO if none of the routes can match request.
+- (BOOL)mayMatchRequest:(JLRRouteRequest *)request;
+
+@end
+
+
+NS_ASSUME_NONNULL_END
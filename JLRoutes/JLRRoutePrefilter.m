@@ -0,0 +1,243 @@
+/*
+ Copyright (c) 2017, Joel Levin
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ 
+ Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ Neither the name of JLRoutes nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import "JLRRoutePrefilter.h"
+#import "JLRRouteDefinition.h"
+#import "JLRRouteIndex.h"
+#import "JLRRouteMatchConstraints.h"
+#import "JLRRouteRequest.h"
+
+
+// Static prefixes longer than this are only added to the Bloom filter up to this many components.
+static const NSUInteger JLRRoutePrefilterMaximumPrefixLength = 4;
+
+// The number of bits set in the Bloom filter for each static prefix, and the number of bits it has per static prefix.
+static const NSUInteger JLRRoutePrefilterHashCount = 3;
+static const NSUInteger JLRRoutePrefilterBitsPerPrefix = 16;
+
+
+// Which path component counts some routes accept: each count below 64 has its own bit, and every count from
+// minimumUnboundedCount on is accepted, for routes ending with a wildcard (or too many components to have bits).
+typedef struct {
+    uint64_t bits;
+    NSUInteger minimumUnboundedCount;
+} JLRRoutePrefilterCounts;
+
+
+static void JLRRoutePrefilterCountsAddRange(JLRRoutePrefilterCounts *counts, NSUInteger minimumCount, NSUInteger maximumCount)
+{
+    for (NSUInteger count = minimumCount; count < 64 && count <= maximumCount; count++) {
+        counts->bits |= (uint64_t)1 << count;
+    }
+    
+    if (maximumCount >= 64) {
+        counts->minimumUnboundedCount = MIN(counts->minimumUnboundedCount, MAX(minimumCount, 64UL));
+    }
+}
+
+static BOOL JLRRoutePrefilterCountsContain(JLRRoutePrefilterCounts counts, NSUInteger count)
+{
+    return count < 64 ? (counts.bits & ((uint64_t)1 << count)) != 0 : count >= counts.minimumUnboundedCount;
+}
+
+// Continues a hash of the path components before this one. Prefixes are hashed one component at a time, so that a
+// request's prefixes of every length are hashed in a single pass over its components.
+static uint64_t JLRRoutePrefilterHashComponent(uint64_t hash, const char *bytes, NSUInteger length)
+{
+    // FNV-1a, with a byte that never appears in UTF-8 after each component so that 'ab' + 'c' and 'a' + 'bc' differ
+    for (NSUInteger index = 0; index < length; index++) {
+        hash = (hash ^ (uint8_t)bytes[index]) * 0x100000001b3ULL;
+    }
+    return (hash ^ 0xff) * 0x100000001b3ULL;
+}
+
+static uint64_t JLRRoutePrefilterMixHash(uint64_t hash)
+{
+    // FNV spreads its entropy poorly across the low bits the Bloom filter indexes with, so finish with a 64-bit mixer
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+static const uint64_t JLRRoutePrefilterHashSeed = 0xcbf29ce484222325ULL;
+
+// The bit of the Bloom filter for the index-th of a prefix's hashes. Double hashing: the bits are h1 + index * h2, with h2
+// odd so that it steps through every bit.
+static NSUInteger JLRRoutePrefilterBloomFilterBit(uint64_t mixedHash, NSUInteger index, NSUInteger bitMask)
+{
+    uint64_t h1 = mixedHash & 0xffffffffULL;
+    uint64_t h2 = (mixedHash >> 32) | 1;
+    return (NSUInteger)((h1 + index * h2) & bitMask);
+}
+
+
+@implementation JLRRoutePrefilter
+{
+    BOOL _acceptsEveryRequest;
+    
+    JLRRoutePrefilterCounts _variablePrefixCounts;
+    JLRRoutePrefilterCounts _staticPrefixCounts;
+    
+    // bit n is set if some route's static prefix (up to the maximum prefix length) has n components
+    uint32_t _staticPrefixLengths;
+    
+    uint64_t *_bloomFilter;
+    NSUInteger _bloomFilterBitMask;
+}
+
+- (instancetype)initWithRoutes:(NSArray <JLRRouteDefinition *> *)routes
+{
+    if ((self = [super init])) {
+        _variablePrefixCounts.minimumUnboundedCount = NSUIntegerMax;
+        _staticPrefixCounts.minimumUnboundedCount = NSUIntegerMax;
+        
+        NSMutableData *prefixHashes = [NSMutableData data];
+        
+        for (JLRRouteDefinition *route in routes) {
+            if (![self _addRoute:route prefixHashes:prefixHashes]) {
+                _acceptsEveryRequest = YES;
+                break;
+            }
+        }
+        
+        NSUInteger prefixCount = prefixHashes.length / sizeof(uint64_t);
+        NSUInteger bitCount = 64;
+        while (bitCount < prefixCount * JLRRoutePrefilterBitsPerPrefix) {
+            bitCount *= 2;
+        }
+        
+        _bloomFilter = calloc(bitCount / 64, sizeof(uint64_t));
+        _bloomFilterBitMask = bitCount - 1;
+        
+        const uint64_t *hashes = prefixHashes.bytes;
+        for (NSUInteger index = 0; index < prefixCount; index++) {
+            uint64_t mixedHash = JLRRoutePrefilterMixHash(hashes[index]);
+            for (NSUInteger hashIndex = 0; hashIndex < JLRRoutePrefilterHashCount; hashIndex++) {
+                NSUInteger bit = JLRRoutePrefilterBloomFilterBit(mixedHash, hashIndex, _bloomFilterBitMask);
+                _bloomFilter[bit / 64] |= (uint64_t)1 << (bit % 64);
+            }
+        }
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    free(_bloomFilter);
+}
+
+- (BOOL)mayMatchRequest:(JLRRouteRequest *)request
+{
+    if (_acceptsEveryRequest) {
+        return YES;
+    }
+    
+    NSUInteger pathComponentCount = request.pathComponentCount;
+    
+    if (JLRRoutePrefilterCountsContain(_variablePrefixCounts, pathComponentCount)) {
+        return YES;
+    }
+    
+    if (!JLRRoutePrefilterCountsContain(_staticPrefixCounts, pathComponentCount)) {
+        return NO;
+    }
+    
+    uint64_t hash = JLRRoutePrefilterHashSeed;
+    
+    for (NSUInteger prefixLength = 1; prefixLength <= MIN(pathComponentCount, JLRRoutePrefilterMaximumPrefixLength); prefixLength++) {
+        NSUInteger length = 0;
+        const char *bytes = [request UTF8StringForPathComponentAtIndex:prefixLength - 1 length:&length];
+        hash = JLRRoutePrefilterHashComponent(hash, bytes, length);
+        
+        if ((_staticPrefixLengths & (1U << prefixLength)) != 0 && [self _bloomFilterContainsHash:hash]) {
+            return YES;
+        }
+    }
+    
+    return NO;
+}
+
+#pragma mark - Private
+
+- (BOOL)_addRoute:(JLRRouteDefinition *)route prefixHashes:(NSMutableData *)prefixHashes
+{
+    // the components (static or ':variable') every match starts with, and the path component counts it may have. These
+    // are the same components and depth the route index files the route under, so the prefilter never rules out a candidate.
+    NSArray <NSString *> *prefix = nil;
+    NSUInteger minimumCount = 0;
+    NSUInteger maximumCount = NSUIntegerMax;
+    
+    if ([JLRRouteIndex canIndexRoute:route]) {
+        NSArray <NSString *> *patternPathComponents = route.patternPathComponents;
+        NSUInteger depth = 0;
+        
+        while (depth < patternPathComponents.count && depth != route.leadingRequiredPathComponentCount && ![patternPathComponents[depth] isEqualToString:@"*"]) {
+            depth++;
+        }
+        
+        prefix = [patternPathComponents subarrayWithRange:NSMakeRange(0, depth)];
+        minimumCount = depth;
+        maximumCount = (depth == patternPathComponents.count) ? depth : NSUIntegerMax;
+    } else {
+        JLRRouteMatchConstraints *constraints = [route matchConstraints];
+        if (constraints == nil) {
+            return NO;
+        }
+        
+        prefix = constraints.literalPrefix;
+        minimumCount = MAX(prefix.count, constraints.minimumPathComponentCount);
+        maximumCount = constraints.maximumPathComponentCount;
+        
+        if (maximumCount < minimumCount) {
+            // constraints that nothing satisfies
+            return YES;
+        }
+    }
+    
+    NSUInteger staticPrefixLength = 0;
+    uint64_t hash = JLRRoutePrefilterHashSeed;
+    
+    while (staticPrefixLength < MIN(prefix.count, JLRRoutePrefilterMaximumPrefixLength) && ![prefix[staticPrefixLength] hasPrefix:@":"]) {
+        const char *bytes = prefix[staticPrefixLength].UTF8String;
+        hash = JLRRoutePrefilterHashComponent(hash, bytes, strlen(bytes));
+        staticPrefixLength++;
+    }
+    
+    if (staticPrefixLength == 0) {
+        JLRRoutePrefilterCountsAddRange(&_variablePrefixCounts, minimumCount, maximumCount);
+    } else {
+        JLRRoutePrefilterCountsAddRange(&_staticPrefixCounts, minimumCount, maximumCount);
+        _staticPrefixLengths |= 1U << staticPrefixLength;
+        [prefixHashes appendBytes:&hash length:sizeof(hash)];
+    }
+    
+    return YES;
+}
+
+- (BOOL)_bloomFilterContainsHash:(uint64_t)hash
+{
+    uint64_t mixedHash = JLRRoutePrefilterMixHash(hash);
+    
+    for (NSUInteger hashIndex = 0; hashIndex < JLRRoutePrefilterHashCount; hashIndex++) {
+        NSUInteger bit = JLRRoutePrefilterBloomFilterBit(mixedHash, hashIndex, _bloomFilterBitMask);
+        if ((_bloomFilter[bit / 64] & ((uint64_t)1 << (bit % 64))) == 0) {
+            return NO;
+        }
+    }
+    
+    return YES;
+}
+
+@end
@@ -0,0 +1,123 @@
+/*
+ Copyright (c) 2017, Joel Levin
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ 
+ Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ Neither the name of JLRoutes nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+
+/// The error domain for errors creating and reading route trace files.
+extern NSString *const JLRRouteRecorderErrorDomain;
+
+/// The codes of errors in JLRRouteRecorderErrorDomain.
+typedef NS_ENUM(NSInteger, JLRRouteRecorderErrorCode) {
+    /// The trace file could not be created or opened.
+    JLRRouteRecorderErrorCannotOpenFile = 1,
+    
+    /// The file is not a route trace, or a line in it is damaged.
+    JLRRouteRecorderErrorCorruptFile
+};
+
+
+/**
+ JLRRouteRecorder appends a line to a trace file for every URL routed while it is set with +[JLRoutes setRouteRecorder:].
+ 
+ Each line holds, separated by tabs: the microseconds since recording started, the nanoseconds routing took (including
+ handler blocks), 'R' if the URL was routed or 'U' if not, the number of handler blocks that declined it, the scheme of
+ the routes controller, the pattern of the route that handled it, the keys of any additional parameters (comma separated),
+ and the URL. Parameter values are never recorded. Fields are percent encoded where needed so they never contain tabs,
+ commas or newlines.
+ 
+ Lines are buffered in memory and written on a background queue, so routing doesn't wait for the file. A trace can be
+ read back with +[JLRRouteRecord recordsWithContentsOfURL:error:], and replayed against one or more route tables with
+ the benchmark in the Benchmarks directory.
+ */
+
+@interface JLRRouteRecorder : NSObject
+
+/// The trace file being written.
+@property (nonatomic, strong, readonly) NSURL *fileURL;
+
+/// The number of records appended so far.
+@property (nonatomic, assign, readonly) NSUInteger recordCount;
+
+/// Unavailable, use -initWithFileURL:error: instead.
+- (instancetype)init NS_UNAVAILABLE;
+
+/// Unavailable, use -initWithFileURL:error: instead.
++ (instancetype)new NS_UNAVAILABLE;
+
+/// Creates a recorder writing to fileURL, replacing any file already there. Returns nil if the file can't be created.
+- (nullable instancetype)initWithFileURL:(NSURL *)fileURL error:(NSError **)error NS_DESIGNATED_INITIALIZER;
+
+/**
+ Appends a record. JLRoutes calls this after routing each URL; it can also be called directly to record URLs routed some other way.
+ 
+ @param URL The URL that was routed.
+ @param additionalParameters The additional parameters it was routed with. Only the keys are recorded.
+ @param scheme The scheme of the routes controller that routed it.
+ @param routePattern The pattern of the route whose handler block returned YES, if any.
+ @param didRoute YES if a handler block returned YES.
+ @param declinedHandlerCount The number of handler blocks that returned NO first.
+ @param duration How long routing took, in nanoseconds.
+ */
+- (void)recordURL:(NSURL *)URL additionalParameters:(nullable NSDictionary *)additionalParameters scheme:(NSString *)scheme routePattern:(nullable NSString *)routePattern didRoute:(BOOL)didRoute declinedHandlerCount:(NSUInteger)declinedHandlerCount duration:(uint64_t)duration;
+
+/// Writes any buffered records to the file, returning once they are written.
+- (void)flush;
+
+/// Writes any buffered records and closes the file. Records appended afterwards are dropped.
+- (void)close;
+
+@end
+
+
+/**
+ JLRRouteRecord is a single line read back from a route trace file.
+ */
+
+@interface JLRRouteRecord : NSObject
+
+/// The microseconds between starting the recording and routing the URL.
+@property (nonatomic, assign, readonly) uint64_t timeOffset;
+
+/// How long routing took, in nanoseconds.
+@property (nonatomic, assign, readonly) uint64_t duration;
+
+/// YES if a handler block returned YES.
+@property (nonatomic, assign, readonly) BOOL didRoute;
+
+/// The number of handler blocks that returned NO before the URL was routed (or given up on).
+@property (nonatomic, assign, readonly) NSUInteger declinedHandlerCount;
+
+/// The scheme of the routes controller that routed the URL.
+@property (nonatomic, copy, readonly) NSString *scheme;
+
+/// The pattern of the route that handled the URL, or nil if it wasn't routed.
+@property (nonatomic, copy, readonly, nullable) NSString *routePattern;
+
+/// The keys of the additional parameters the URL was routed with.
+@property (nonatomic, copy, readonly) NSArray <NSString *> *parameterKeys;
+
+/// The URL that was routed.
+@property (nonatomic, strong, readonly) NSURL *URL;
+
+/// Returns the records in the trace file at fileURL, in the order they were recorded, or nil if it can't be read.
++ (nullable NSArray <JLRRouteRecord *> *)recordsWithContentsOfURL:(NSURL *)fileURL error:(NSError **)error;
+
+/// Returns the records in data, which has the contents of a trace file.
++ (nullable NSArray <JLRRouteRecord *> *)recordsWithData:(NSData *)data error:(NSError **)error;
+
+@end
+
+
+NS_ASSUME_NONNULL_END
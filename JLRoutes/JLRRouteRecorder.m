@@ -0,0 +1,298 @@
+/*
+ Copyright (c) 2017, Joel Levin
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ 
+ Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ Neither the name of JLRoutes nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import "JLRRouteRecorder.h"
+
+
+NSString *const JLRRouteRecorderErrorDomain = @"JLRRouteRecorderErrorDomain";
+
+// The first line of every trace file, which changes if the format of the lines after it ever does.
+static NSString *const JLRRouteTraceFileHeader = @"#JLRoutes trace 1\n";
+
+// The number of fields in a record line.
+static const NSUInteger JLRRouteTraceFieldCount = 8;
+
+// Buffered records are handed off to be written once they reach this size.
+static const NSUInteger JLRRouteRecorderBufferSize = 64 * 1024;
+
+
+static NSError *JLRRouteRecorderError(JLRRouteRecorderErrorCode code, NSString *description)
+{
+    return [NSError errorWithDomain:JLRRouteRecorderErrorDomain code:code userInfo:@{NSLocalizedDescriptionKey: description}];
+}
+
+
+// Percent encodes the characters that separate fields and keys (and '%' itself), so the field can be decoded again.
+static NSString *JLRRouteTraceEscapedField(NSString *field)
+{
+    static NSCharacterSet *reservedCharacters = nil;
+    static NSCharacterSet *allowedCharacters = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        reservedCharacters = [NSCharacterSet characterSetWithCharactersInString:@"%,\t\r\n"];
+        allowedCharacters = [reservedCharacters invertedSet];
+    });
+    
+    if ([field rangeOfCharacterFromSet:reservedCharacters].location == NSNotFound) {
+        return field;
+    }
+    
+    return [field stringByAddingPercentEncodingWithAllowedCharacters:allowedCharacters];
+}
+
+
+static NSString *JLRRouteTraceUnescapedField(NSString *field)
+{
+    if ([field rangeOfString:@"%"].location == NSNotFound) {
+        return field;
+    }
+    
+    return [field stringByRemovingPercentEncoding];
+}
+
+
+@implementation JLRRouteRecorder
+{
+    NSFileHandle *_fileHandle;
+    NSMutableData *_buffer;
+    dispatch_queue_t _writeQueue;
+    NSTimeInterval _startTime;
+    NSUInteger _recordCount;
+    BOOL _closed;
+}
+
+- (instancetype)initWithFileURL:(NSURL *)fileURL error:(NSError **)error
+{
+    if ((self = [super init])) {
+        NSData *header = [JLRRouteTraceFileHeader dataUsingEncoding:NSUTF8StringEncoding];
+        NSFileHandle *fileHandle = nil;
+        
+        if (fileURL.isFileURL && [[NSFileManager defaultManager] createFileAtPath:fileURL.path contents:header attributes:nil]) {
+            fileHandle = [NSFileHandle fileHandleForWritingAtPath:fileURL.path];
+        }
+        
+        if (fileHandle == nil) {
+            if (error != NULL) {
+                *error = JLRRouteRecorderError(JLRRouteRecorderErrorCannotOpenFile, [NSString stringWithFormat:@"Couldn't create the trace file at %@.", fileURL]);
+            }
+            return nil;
+        }
+        
+        [fileHandle seekToEndOfFile];
+        
+        _fileURL = fileURL;
+        _fileHandle = fileHandle;
+        _buffer = [NSMutableData dataWithCapacity:JLRRouteRecorderBufferSize];
+        _writeQueue = dispatch_queue_create("com.jlroutes.route-recorder", DISPATCH_QUEUE_SERIAL);
+        _startTime = [NSProcessInfo processInfo].systemUptime;
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    [self close];
+}
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"<%@ %p> - %@ (%@ records)", NSStringFromClass([self class]), self, self.fileURL.path, @(self.recordCount)];
+}
+
+- (NSUInteger)recordCount
+{
+    @synchronized (self) {
+        return _recordCount;
+    }
+}
+
+- (void)recordURL:(NSURL *)URL additionalParameters:(NSDictionary *)additionalParameters scheme:(NSString *)scheme routePattern:(NSString *)routePattern didRoute:(BOOL)didRoute declinedHandlerCount:(NSUInteger)declinedHandlerCount duration:(uint64_t)duration
+{
+    uint64_t timeOffset = (uint64_t)(([NSProcessInfo processInfo].systemUptime - _startTime) * USEC_PER_SEC);
+    NSMutableArray <NSString *> *parameterKeys = [NSMutableArray arrayWithCapacity:additionalParameters.count];
+    
+    for (id key in additionalParameters) {
+        [parameterKeys addObject:JLRRouteTraceEscapedField([key description])];
+    }
+    
+    // keys are sorted so that traces of the same traffic compare equal
+    [parameterKeys sortUsingSelector:@selector(compare:)];
+    
+    // URLs can't contain tabs or newlines, and they are the last field, so they are written as they are
+    NSString *line = [NSString stringWithFormat:@"%llu\t%llu\t%c\t%lu\t%@\t%@\t%@\t%@\n", (unsigned long long)timeOffset, (unsigned long long)duration, (didRoute ? 'R' : 'U'), (unsigned long)declinedHandlerCount, JLRRouteTraceEscapedField(scheme), JLRRouteTraceEscapedField(routePattern ?: @""), [parameterKeys componentsJoinedByString:@","], URL.absoluteString];
+    const char *bytes = line.UTF8String;
+    
+    @synchronized (self) {
+        if (_closed) {
+            return;
+        }
+        
+        [_buffer appendBytes:bytes length:strlen(bytes)];
+        _recordCount++;
+        
+        if (_buffer.length >= JLRRouteRecorderBufferSize) {
+            [self _writeBufferedRecords];
+        }
+    }
+}
+
+- (void)flush
+{
+    @synchronized (self) {
+        if (_closed) {
+            return;
+        }
+        [self _writeBufferedRecords];
+    }
+    
+    // waits for every write handed off so far, including the one just made
+    dispatch_sync(_writeQueue, ^{});
+}
+
+- (void)close
+{
+    NSFileHandle *fileHandle = nil;
+    
+    @synchronized (self) {
+        if (_closed) {
+            return;
+        }
+        [self _writeBufferedRecords];
+        _closed = YES;
+        fileHandle = _fileHandle;
+        _fileHandle = nil;
+    }
+    
+    dispatch_sync(_writeQueue, ^{
+        [fileHandle closeFile];
+    });
+}
+
+#pragma mark - Private
+
+- (void)_writeBufferedRecords
+{
+    // must be called while synchronized on self; writes are queued in the order buffers fill up, so records stay in order
+    if (_buffer.length == 0) {
+        return;
+    }
+    
+    NSData *data = _buffer;
+    NSFileHandle *fileHandle = _fileHandle;
+    _buffer = [NSMutableData dataWithCapacity:JLRRouteRecorderBufferSize];
+    
+    dispatch_async(_writeQueue, ^{
+        [fileHandle writeData:data];
+    });
+}
+
+@end
+
+
+#pragma mark -
+
+@interface JLRRouteRecord ()
+
+@property (nonatomic, assign) uint64_t timeOffset;
+@property (nonatomic, assign) uint64_t duration;
+@property (nonatomic, assign) BOOL didRoute;
+@property (nonatomic, assign) NSUInteger declinedHandlerCount;
+@property (nonatomic, copy) NSString *scheme;
+@property (nonatomic, copy, nullable) NSString *routePattern;
+@property (nonatomic, copy) NSArray <NSString *> *parameterKeys;
+@property (nonatomic, strong) NSURL *URL;
+
+@end
+
+
+@implementation JLRRouteRecord
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"<%@ %p> - %@ %@ (%@, %@ declined, %@ ns)", NSStringFromClass([self class]), self, (self.didRoute ? @"routed" : @"did not route"), self.URL, self.routePattern ?: @"no route", @(self.declinedHandlerCount), @(self.duration)];
+}
+
++ (NSArray <JLRRouteRecord *> *)recordsWithContentsOfURL:(NSURL *)fileURL error:(NSError **)error
+{
+    NSData *data = [NSData dataWithContentsOfURL:fileURL options:NSDataReadingMappedIfSafe error:error];
+    if (data == nil) {
+        return nil;
+    }
+    
+    return [self recordsWithData:data error:error];
+}
+
++ (NSArray <JLRRouteRecord *> *)recordsWithData:(NSData *)data error:(NSError **)error
+{
+    NSString *contents = [[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding];
+    
+    if (![contents hasPrefix:JLRRouteTraceFileHeader]) {
+        if (error != NULL) {
+            *error = JLRRouteRecorderError(JLRRouteRecorderErrorCorruptFile, @"The data is not a route trace.");
+        }
+        return nil;
+    }
+    
+    NSArray <NSString *> *lines = [[contents substringFromIndex:JLRRouteTraceFileHeader.length] componentsSeparatedByString:@"\n"];
+    NSMutableArray <JLRRouteRecord *> *records = [NSMutableArray arrayWithCapacity:lines.count];
+    
+    // the last line is either empty or was cut off while being written (if the process exited before closing the recorder), so it is skipped
+    for (NSUInteger lineIndex = 0; lineIndex + 1 < lines.count; lineIndex++) {
+        JLRRouteRecord *record = [self _recordWithLine:lines[lineIndex]];
+        
+        if (record == nil) {
+            if (error != NULL) {
+                *error = JLRRouteRecorderError(JLRRouteRecorderErrorCorruptFile, [NSString stringWithFormat:@"Line %@ of the route trace is damaged.", @(lineIndex + 2)]);
+            }
+            return nil;
+        }
+        
+        [records addObject:record];
+    }
+    
+    return [records copy];
+}
+
++ (nullable instancetype)_recordWithLine:(NSString *)line
+{
+    NSArray <NSString *> *fields = [line componentsSeparatedByString:@"\t"];
+    if (fields.count != JLRRouteTraceFieldCount) {
+        return nil;
+    }
+    
+    NSString *outcome = fields[2];
+    NSURL *URL = [NSURL URLWithString:fields[7]];
+    if (URL == nil || !([outcome isEqualToString:@"R"] || [outcome isEqualToString:@"U"])) {
+        return nil;
+    }
+    
+    NSMutableArray <NSString *> *parameterKeys = [NSMutableArray array];
+    if (fields[6].length > 0) {
+        for (NSString *key in [fields[6] componentsSeparatedByString:@","]) {
+            [parameterKeys addObject:JLRRouteTraceUnescapedField(key)];
+        }
+    }
+    
+    JLRRouteRecord *record = [[self alloc] init];
+    record.timeOffset = strtoull(fields[0].UTF8String, NULL, 10);
+    record.duration = strtoull(fields[1].UTF8String, NULL, 10);
+    record.didRoute = [outcome isEqualToString:@"R"];
+    record.declinedHandlerCount = (NSUInteger)strtoull(fields[3].UTF8String, NULL, 10);
+    record.scheme = JLRRouteTraceUnescapedField(fields[4]);
+    record.routePattern = (fields[5].length > 0) ? JLRRouteTraceUnescapedField(fields[5]) : nil;
+    record.parameterKeys = parameterKeys;
+    record.URL = URL;
+    
+    return record;
+}
+
+@end
@@ -31,6 +31,9 @@ typedef NS_OPTIONS(NSUInteger, JLRRouteRequestOptions) {
 /**
  JLRRouteRequest is a model representing a request to route a URL.
  It gets parsed into path components and query parameters, which are then used by JLRRouteDefinition to attempt a match.
+ 
+ Requests can be read from any thread. Each lazily parsed value is created once, under a lock on the request, and
+ only read without the lock once it is complete.
  */
 
 @interface JLRRouteRequest : NSObject
@@ -38,10 +41,10 @@ typedef NS_OPTIONS(NSUInteger, JLRRouteRequestOptions) {
 /// The URL being routed.
 @property (nonatomic, copy, readonly) NSURL *URL;
 
-/// The URL's path components.
+/// The URL's path components. Created from the URL the first time they are accessed.
 @property (nonatomic, strong, readonly) NSArray *pathComponents;
 
-/// The URL's query parameters.
+/// The URL's query parameters, including any found in the fragment. Created from the URL the first time they are accessed.
 @property (nonatomic, strong, readonly) NSDictionary *queryParams;
 
 /// Route request options, generally configured from the framework global options.
@@ -73,6 +76,52 @@ typedef NS_OPTIONS(NSUInteger, JLRRouteRequestOptions) {
 /// Unavailable, use initWithURL:options:additionalParameters: instead.
 + (instancetype)new NS_UNAVAILABLE;
 
+
+///-------------------------------
+/// @name Reading Path Components
+///-------------------------------
+
+
+/// The number of path components, which can be read without creating the pathComponents array.
+@property (nonatomic, assign, readonly) NSUInteger pathComponentCount;
+
+/**
+ Compares a path component against a string without creating an NSString for it.
+ 
+ @param index The index of the path component, which must be less than pathComponentCount.
+ @param string The UTF-8 bytes to compare against. They don't need to be NUL terminated.
+ @param length The number of bytes in string.
+ 
+ @returns YES if the path component is made up of exactly the given bytes.
+ */
+- (BOOL)pathComponentAtIndex:(NSUInteger)index isEqualToUTF8String:(const char *)string length:(NSUInteger)length;
+
+/**
+ Returns the bytes of a path component, still percent encoded, without creating an NSString for it.
+ 
+ @param index The index of the path component, which must be less than pathComponentCount.
+ @param length Set to the number of bytes in the path component.
+ 
+ @returns The path component's UTF-8 bytes, which are not NUL terminated and stay valid for the lifetime of the request.
+ */
+- (const char *)UTF8StringForPathComponentAtIndex:(NSUInteger)index length:(NSUInteger *)length;
+
+
+///-------------------------------
+/// @name Reading Query Parameters
+///-------------------------------
+
+
+/**
+ Returns the value of a query parameter, with plus symbols decoded if the request's options call for it.
+ Decoded values are cached on the request, so every route that attempts to match it shares them.
+ 
+ @param key The name of the query parameter.
+ 
+ @returns The value, which is either an NSString or an NSArray of them, or nil if the URL has no such query parameter.
+ */
+- (nullable id)queryParamValueForKey:(NSString *)key;
+
 @end
 
 
@@ -11,13 +11,173 @@
  */
 
 #import "JLRRouteRequest.h"
+#import "JLRParsingUtilities.h"
+#import <stdatomic.h>
+
+
+// Byte ranges of the parts of a URL reference, found by a single scan over its UTF-8 representation.
+// Parts that aren't present have a location of NSNotFound.
+typedef struct {
+    NSRange host;
+    NSRange path;
+    NSRange query;
+    NSRange fragment;
+} JLRRouteRequestURLRanges;
+
+
+static BOOL JLRRouteRequestIsSchemeCharacter(char character, BOOL isFirstCharacter)
+{
+    if ((character >= 'a' && character <= 'z') || (character >= 'A' && character <= 'Z')) {
+        return YES;
+    }
+    return !isFirstCharacter && ((character >= '0' && character <= '9') || character == '+' || character == '-' || character == '.');
+}
+
+static NSRange JLRRouteRequestHostRangeInAuthority(const char *bytes, NSRange authority)
+{
+    NSUInteger start = authority.location;
+    NSUInteger end = NSMaxRange(authority);
+    
+    // skip over any user info
+    for (NSUInteger index = start; index < end; index++) {
+        if (bytes[index] == '@') {
+            start = index + 1;
+        }
+    }
+    
+    // and drop the port
+    if (start < end && bytes[start] == '[') {
+        for (NSUInteger index = start; index < end; index++) {
+            if (bytes[index] == ']') {
+                end = index + 1;
+                break;
+            }
+        }
+    } else {
+        for (NSUInteger index = start; index < end; index++) {
+            if (bytes[index] == ':') {
+                end = index;
+                break;
+            }
+        }
+    }
+    
+    return NSMakeRange(start, end - start);
+}
+
+static JLRRouteRequestURLRanges JLRRouteRequestScanURLReference(const char *bytes, NSUInteger location, NSUInteger end)
+{
+    JLRRouteRequestURLRanges ranges = {{NSNotFound, 0}, {location, 0}, {NSNotFound, 0}, {NSNotFound, 0}};
+    NSUInteger index = location;
+    
+    // scheme, which is only a scheme if it's terminated by a ':'
+    while (index < end && JLRRouteRequestIsSchemeCharacter(bytes[index], index == location)) {
+        index++;
+    }
+    if (index > location && index < end && bytes[index] == ':') {
+        location = index + 1;
+    }
+    index = location;
+    
+    // authority
+    if (end - index >= 2 && bytes[index] == '/' && bytes[index + 1] == '/') {
+        NSUInteger authorityStart = index + 2;
+        index = authorityStart;
+        while (index < end && bytes[index] != '/' && bytes[index] != '?' && bytes[index] != '#') {
+            index++;
+        }
+        ranges.host = JLRRouteRequestHostRangeInAuthority(bytes, NSMakeRange(authorityStart, index - authorityStart));
+    }
+    
+    // path
+    NSUInteger pathStart = index;
+    while (index < end && bytes[index] != '?' && bytes[index] != '#') {
+        index++;
+    }
+    ranges.path = NSMakeRange(pathStart, index - pathStart);
+    
+    // query
+    if (index < end && bytes[index] == '?') {
+        NSUInteger queryStart = ++index;
+        while (index < end && bytes[index] != '#') {
+            index++;
+        }
+        ranges.query = NSMakeRange(queryStart, index - queryStart);
+    }
+    
+    // fragment
+    if (index < end && bytes[index] == '#') {
+        ranges.fragment = NSMakeRange(index + 1, end - index - 1);
+    }
+    
+    return ranges;
+}
+
+static NSString *JLRRouteRequestStringFromBytes(const char *bytes, NSRange range, BOOL removePercentEncoding)
+{
+    NSString *string = nil;
+    
+    if (removePercentEncoding) {
+        string = [JLRParsingUtilities stringByDecodingUTF8Bytes:bytes + range.location length:range.length removePercentEncoding:YES decodePlusSymbols:NO];
+    }
+    
+    // invalid percent escapes are left as they are
+    return string ?: [[NSString alloc] initWithBytes:bytes + range.location length:range.length encoding:NSUTF8StringEncoding] ?: @"";
+}
+
+static BOOL JLRRouteRequestFirstQueryItemHasValue(const char *bytes, NSRange range)
+{
+    for (NSUInteger index = range.location; index < NSMaxRange(range) && bytes[index] != '&'; index++) {
+        if (bytes[index] == '=') {
+            return index + 1 < NSMaxRange(range) && bytes[index + 1] != '&';
+        }
+    }
+    return NO;
+}
+
+static void JLRRouteRequestAddQueryItems(const char *bytes, NSRange range, BOOL removePercentEncoding, NSMutableDictionary *queryParams)
+{
+    NSUInteger end = NSMaxRange(range);
+    NSUInteger index = range.location;
+    
+    while (index <= end) {
+        NSUInteger itemStart = index;
+        NSUInteger separator = NSNotFound;
+        
+        while (index < end && bytes[index] != '&') {
+            if (bytes[index] == '=' && separator == NSNotFound) {
+                separator = index;
+            }
+            index++;
+        }
+        
+        // items without a value ('?a&b=c') are skipped
+        if (separator != NSNotFound) {
+            NSString *name = JLRRouteRequestStringFromBytes(bytes, NSMakeRange(itemStart, separator - itemStart), removePercentEncoding);
+            NSString *value = JLRRouteRequestStringFromBytes(bytes, NSMakeRange(separator + 1, index - separator - 1), removePercentEncoding);
+            id existingValue = queryParams[name];
+            
+            if (existingValue == nil) {
+                // first time seeing a param with this name, set it
+                queryParams[name] = value;
+            } else if ([existingValue isKindOfClass:[NSArray class]]) {
+                // already an array of these items, append it
+                queryParams[name] = [(NSArray *)existingValue arrayByAddingObject:value];
+            } else {
+                // existing non-array value for this key, create an array
+                queryParams[name] = @[existingValue, value];
+            }
+        }
+        
+        // step over the '&'
+        index++;
+    }
+}
 
 
 @interface JLRRouteRequest ()
 
 @property (nonatomic, copy) NSURL *URL;
-@property (nonatomic, strong) NSArray *pathComponents;
-@property (nonatomic, strong) NSDictionary *queryParams;
 @property (nonatomic, assign) JLRRouteRequestOptions options;
 @property (nonatomic, copy) NSDictionary *additionalParameters;
 
@@ -25,6 +185,29 @@
 
 
 @implementation JLRRouteRequest
+{
+    NSString *_URLString;
+    JLRRouteRequestURLRanges _URLRanges;
+    
+    BOOL _didParseFragment;
+    BOOL _appendsFragmentPath;
+    NSRange _fragmentPathRange;
+    NSString *_fragmentQuery;
+    BOOL _fragmentQueryNeedsPercentDecoding;
+    
+    // the path assembled from the URL, with the byte range of each component in it
+    _Atomic(BOOL) _didParsePath;
+    char *_path;
+    NSRange *_pathComponentRanges;
+    NSUInteger _pathComponentCount;
+    
+    // everything below is created while synchronized on self, and only read without it once its flag is set
+    _Atomic(BOOL) _didCreatePathComponents;
+    NSArray *_pathComponents;
+    _Atomic(BOOL) _didCreateQueryParams;
+    NSDictionary *_queryParams;
+    NSMutableDictionary *_decodedQueryParams;
+}
 
 - (instancetype)initWithURL:(NSURL *)URL options:(JLRRouteRequestOptions)options additionalParameters:(nullable NSDictionary *)additionalParameters
 {
@@ -33,87 +216,282 @@
         self.options = options;
         self.additionalParameters = additionalParameters;
         
-        BOOL treatsHostAsPathComponent = ((options & JLRRouteRequestOptionTreatHostAsPathComponent) == JLRRouteRequestOptionTreatHostAsPathComponent);
-        
-        NSURLComponents *components = [NSURLComponents componentsWithString:[self.URL absoluteString]];
-        
-        if (components.host.length > 0 && (treatsHostAsPathComponent || (![components.host isEqualToString:@"localhost"] && [components.host rangeOfString:@"."].location == NSNotFound))) {
-            // convert the host to "/" so that the host is considered a path component
-            NSString *host = [components.percentEncodedHost copy];
-            components.host = @"/";
-            components.percentEncodedPath = [host stringByAppendingPathComponent:(components.percentEncodedPath ?: @"")];
-        }
-        
-        NSString *path = [components percentEncodedPath];
-        
-        // handle fragment if needed
-        if (components.fragment != nil) {
-            BOOL fragmentContainsQueryParams = NO;
-            NSURLComponents *fragmentComponents = [NSURLComponents componentsWithString:components.percentEncodedFragment];
-            
-            if (fragmentComponents.query == nil && fragmentComponents.path != nil) {
-                fragmentComponents.query = fragmentComponents.path;
-            }
-            
-            if (fragmentComponents.queryItems.count > 0) {
-                // determine if this fragment is only valid query params and nothing else
-                fragmentContainsQueryParams = fragmentComponents.queryItems.firstObject.value.length > 0;
-            }
-            
-            if (fragmentContainsQueryParams) {
-                // include fragment query params in with the standard set
-                components.queryItems = [(components.queryItems ?: @[]) arrayByAddingObjectsFromArray:fragmentComponents.queryItems];
-            }
+        // Only record where each part of the URL is. Path components and query params are created the first time they're asked for.
+        _URLString = [[self.URL absoluteString] copy] ?: @"";
+        const char *bytes = _URLString.UTF8String ?: "";
+        _URLRanges = JLRRouteRequestScanURLReference(bytes, 0, strlen(bytes));
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    free(_path);
+    free(_pathComponentRanges);
+}
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"<%@ %p> - URL: %@", NSStringFromClass([self class]), self, [self.URL absoluteString]];
+}
+
+#pragma mark - Parsed Values
+
+- (NSArray *)pathComponents
+{
+    if (atomic_load_explicit(&_didCreatePathComponents, memory_order_acquire)) {
+        return _pathComponents;
+    }
+    
+    @synchronized (self) {
+        if (_pathComponents == nil) {
+            [self _parsePathIfNeeded];
             
-            if (fragmentComponents.path != nil && (!fragmentContainsQueryParams || ![fragmentComponents.path isEqualToString:fragmentComponents.query])) {
-                // handle fragment by include fragment path as part of the main path
-                path = [path stringByAppendingString:[NSString stringWithFormat:@"#%@", fragmentComponents.percentEncodedPath]];
+            NSMutableArray *pathComponents = [NSMutableArray arrayWithCapacity:_pathComponentCount];
+            for (NSUInteger index = 0; index < _pathComponentCount; index++) {
+                [pathComponents addObject:JLRRouteRequestStringFromBytes(_path, _pathComponentRanges[index], NO)];
             }
+            _pathComponents = [pathComponents copy];
+            atomic_store_explicit(&_didCreatePathComponents, YES, memory_order_release);
         }
-        
-        // strip off leading slash so that we don't have an empty first path component
-        if (path.length > 0 && [path characterAtIndex:0] == '/') {
-            path = [path substringFromIndex:1];
+        return _pathComponents;
+    }
+}
+
+- (const char *)UTF8StringForPathComponentAtIndex:(NSUInteger)index length:(NSUInteger *)length
+{
+    [self _parsePathIfNeeded];
+    NSParameterAssert(index < _pathComponentCount);
+    
+    NSRange range = _pathComponentRanges[index];
+    *length = range.length;
+    return _path + range.location;
+}
+
+- (NSUInteger)pathComponentCount
+{
+    [self _parsePathIfNeeded];
+    return _pathComponentCount;
+}
+
+- (BOOL)pathComponentAtIndex:(NSUInteger)index isEqualToUTF8String:(const char *)string length:(NSUInteger)length
+{
+    [self _parsePathIfNeeded];
+    NSParameterAssert(index < _pathComponentCount);
+    
+    NSRange range = _pathComponentRanges[index];
+    return range.length == length && memcmp(_path + range.location, string, length) == 0;
+}
+
+- (NSDictionary *)queryParams
+{
+    if (atomic_load_explicit(&_didCreateQueryParams, memory_order_acquire)) {
+        return _queryParams;
+    }
+    
+    @synchronized (self) {
+        if (_queryParams == nil) {
+            _queryParams = [self _parseQueryParams];
+            atomic_store_explicit(&_didCreateQueryParams, YES, memory_order_release);
         }
+        return _queryParams;
+    }
+}
+
+- (nullable id)queryParamValueForKey:(NSString *)key
+{
+    id value = self.queryParams[key];
+    BOOL decodePlusSymbols = ((self.options & JLRRouteRequestOptionDecodePlusSymbols) == JLRRouteRequestOptionDecodePlusSymbols);
+    
+    if (value == nil || !decodePlusSymbols) {
+        return value;
+    }
+    
+    @synchronized (self) {
+        id decodedValue = _decodedQueryParams[key];
         
-        // strip off trailing slash for the same reason
-        if (path.length > 0 && [path characterAtIndex:path.length - 1] == '/') {
-            path = [path substringToIndex:path.length - 1];
+        if (decodedValue == nil) {
+            decodedValue = [JLRParsingUtilities queryParamValue:value decodePlusSymbols:YES];
+            
+            if (_decodedQueryParams == nil) {
+                _decodedQueryParams = [NSMutableDictionary dictionary];
+            }
+            _decodedQueryParams[key] = decodedValue;
         }
         
-        // split apart into path components
-        self.pathComponents = [path componentsSeparatedByString:@"/"];
+        return decodedValue;
+    }
+}
+
+#pragma mark - Parsing
+
+- (void)_parsePathIfNeeded
+{
+    // matching reads the path components over and over, so only the first read takes the lock
+    if (atomic_load_explicit(&_didParsePath, memory_order_acquire)) {
+        return;
+    }
+    
+    @synchronized (self) {
+        if (!atomic_load_explicit(&_didParsePath, memory_order_relaxed)) {
+            [self _parsePath];
+            atomic_store_explicit(&_didParsePath, YES, memory_order_release);
+        }
+    }
+}
+
+- (void)_parsePath
+{
+    // must be called while synchronized on self
+    const char *bytes = _URLString.UTF8String ?: "";
+    NSRange hostRange = _URLRanges.host;
+    NSRange pathRange = _URLRanges.path;
+    
+    [self _parseFragmentIfNeeded];
+    
+    // the path is assembled into a single buffer: [host] + path + ['#' + fragment path]
+    char *path = malloc(hostRange.length + pathRange.length + _fragmentPathRange.length + 2);
+    NSUInteger pathLength = 0;
+    
+    if ([self _treatsHostAsPathComponent]) {
+        // the host is considered the first path component, and like -stringByAppendingPathComponent: empty components are dropped
+        memcpy(path, bytes + hostRange.location, hostRange.length);
+        pathLength = hostRange.length;
         
-        // convert query items into a dictionary
-        NSArray <NSURLQueryItem *> *queryItems = [components queryItems] ?: @[];
-        NSMutableDictionary *queryParams = [NSMutableDictionary dictionary];
-        for (NSURLQueryItem *item in queryItems) {
-            if (item.value == nil) {
-                continue;
-            }
-            
-            if (queryParams[item.name] == nil) {
-                // first time seeing a param with this name, set it
-                queryParams[item.name] = item.value;
-            } else if ([queryParams[item.name] isKindOfClass:[NSArray class]]) {
-                // already an array of these items, append it
-                NSArray *values = (NSArray *)(queryParams[item.name]);
-                queryParams[item.name] = [values arrayByAddingObject:item.value];
-            } else {
-                // existing non-array value for this key, create an array
-                id existingValue = queryParams[item.name];
-                queryParams[item.name] = @[existingValue, item.value];
+        NSUInteger componentStart = pathRange.location;
+        for (NSUInteger index = pathRange.location; index <= NSMaxRange(pathRange); index++) {
+            if (index == NSMaxRange(pathRange) || bytes[index] == '/') {
+                if (index > componentStart) {
+                    path[pathLength++] = '/';
+                    memcpy(path + pathLength, bytes + componentStart, index - componentStart);
+                    pathLength += index - componentStart;
+                }
+                componentStart = index + 1;
             }
         }
-        
-        self.queryParams = [queryParams copy];
+    } else {
+        memcpy(path, bytes + pathRange.location, pathRange.length);
+        pathLength = pathRange.length;
     }
-    return self;
+    
+    if (_appendsFragmentPath) {
+        // handle fragment by include fragment path as part of the main path
+        path[pathLength++] = '#';
+        memcpy(path + pathLength, bytes + _fragmentPathRange.location, _fragmentPathRange.length);
+        pathLength += _fragmentPathRange.length;
+    }
+    
+    // strip off leading slash so that we don't have an empty first path component
+    NSUInteger pathStart = 0;
+    if (pathLength > 0 && path[0] == '/') {
+        pathStart = 1;
+    }
+    
+    // strip off trailing slash for the same reason
+    if (pathLength > pathStart && path[pathLength - 1] == '/') {
+        pathLength--;
+    }
+    
+    // split apart into path components, which are only turned into strings if they're asked for
+    NSUInteger componentCount = 1;
+    for (NSUInteger index = pathStart; index < pathLength; index++) {
+        if (path[index] == '/') {
+            componentCount++;
+        }
+    }
+    
+    _pathComponentRanges = malloc(componentCount * sizeof(NSRange));
+    _pathComponentCount = 0;
+    
+    NSUInteger componentStart = pathStart;
+    for (NSUInteger index = pathStart; index <= pathLength; index++) {
+        if (index == pathLength || path[index] == '/') {
+            _pathComponentRanges[_pathComponentCount++] = NSMakeRange(componentStart, index - componentStart);
+            componentStart = index + 1;
+        }
+    }
+    
+    _path = path;
 }
 
-- (NSString *)description
+- (NSDictionary *)_parseQueryParams
 {
-    return [NSString stringWithFormat:@"<%@ %p> - URL: %@", NSStringFromClass([self class]), self, [self.URL absoluteString]];
+    // must be called while synchronized on self, since it shares the parsed fragment with -_parsePath
+    NSMutableDictionary *queryParams = [NSMutableDictionary dictionary];
+    
+    if (_URLRanges.query.location != NSNotFound) {
+        JLRRouteRequestAddQueryItems(_URLString.UTF8String, _URLRanges.query, YES, queryParams);
+    }
+    
+    [self _parseFragmentIfNeeded];
+    
+    if (_fragmentQuery != nil) {
+        // include fragment query params in with the standard set
+        const char *fragmentQueryBytes = _fragmentQuery.UTF8String ?: "";
+        JLRRouteRequestAddQueryItems(fragmentQueryBytes, NSMakeRange(0, strlen(fragmentQueryBytes)), _fragmentQueryNeedsPercentDecoding, queryParams);
+    }
+    
+    return [queryParams copy];
+}
+
+- (BOOL)_treatsHostAsPathComponent
+{
+    NSRange hostRange = _URLRanges.host;
+    
+    if (hostRange.location == NSNotFound || hostRange.length == 0) {
+        return NO;
+    }
+    
+    if ((self.options & JLRRouteRequestOptionTreatHostAsPathComponent) == JLRRouteRequestOptionTreatHostAsPathComponent) {
+        return YES;
+    }
+    
+    // otherwise, only hosts that don't look like real hosts ('localhost' or anything with a '.') are path components
+    NSString *host = JLRRouteRequestStringFromBytes(_URLString.UTF8String, hostRange, YES);
+    return ![host isEqualToString:@"localhost"] && [host rangeOfString:@"."].location == NSNotFound;
+}
+
+- (void)_parseFragmentIfNeeded
+{
+    // must be called while synchronized on self
+    if (_didParseFragment) {
+        return;
+    }
+    
+    _didParseFragment = YES;
+    
+    if (_URLRanges.fragment.location == NSNotFound) {
+        return;
+    }
+    
+    // the fragment itself is parsed like a URL, so '#/path?a=b' has both a path and query params
+    const char *bytes = _URLString.UTF8String;
+    JLRRouteRequestURLRanges fragmentRanges = JLRRouteRequestScanURLReference(bytes, _URLRanges.fragment.location, NSMaxRange(_URLRanges.fragment));
+    NSString *fragmentPath = JLRRouteRequestStringFromBytes(bytes, fragmentRanges.path, YES);
+    NSString *fragmentQuery = nil;
+    BOOL fragmentContainsQueryParams = NO;
+    
+    if (fragmentRanges.query.location == NSNotFound) {
+        // without a '?', the (decoded) fragment path doubles as the query, as in '#a=b&c=d'
+        fragmentQuery = fragmentPath;
+        const char *fragmentQueryBytes = fragmentQuery.UTF8String ?: "";
+        fragmentContainsQueryParams = JLRRouteRequestFirstQueryItemHasValue(fragmentQueryBytes, NSMakeRange(0, strlen(fragmentQueryBytes)));
+        _fragmentQueryNeedsPercentDecoding = NO;
+    } else {
+        fragmentQuery = JLRRouteRequestStringFromBytes(bytes, fragmentRanges.query, NO);
+        fragmentContainsQueryParams = JLRRouteRequestFirstQueryItemHasValue(bytes, fragmentRanges.query);
+        _fragmentQueryNeedsPercentDecoding = YES;
+    }
+    
+    if (fragmentContainsQueryParams) {
+        _fragmentQuery = fragmentQuery;
+    }
+    
+    NSString *decodedFragmentQuery = _fragmentQueryNeedsPercentDecoding ? ([fragmentQuery stringByRemovingPercentEncoding] ?: fragmentQuery) : fragmentQuery;
+    if (!fragmentContainsQueryParams || ![fragmentPath isEqualToString:decodedFragmentQuery]) {
+        _appendsFragmentPath = YES;
+        _fragmentPathRange = fragmentRanges.path;
+    }
 }
 
 @end
@@ -36,7 +36,7 @@ NS_ASSUME_NONNULL_BEGIN
 ///-------------------------------
 
 
-/// Creates an invalid match response.
+/// Returns an invalid match response. Every invalid match shares one instance, so misses don't allocate.
 + (instancetype)invalidMatchResponse;
 
 /// Creates a valid match response with the given parameters.
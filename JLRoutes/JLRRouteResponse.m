@@ -25,9 +25,20 @@
 
 + (instancetype)invalidMatchResponse
 {
-    JLRRouteResponse *response = [[[self class] alloc] init];
-    response.match = NO;
-    return response;
+    if (self != [JLRRouteResponse class]) {
+        JLRRouteResponse *response = [[[self class] alloc] init];
+        response.match = NO;
+        return response;
+    }
+    
+    // responses are immutable, so every miss can share the same one instead of allocating its own
+    static JLRRouteResponse *invalidMatchResponse = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        invalidMatchResponse = [[JLRRouteResponse alloc] init];
+        invalidMatchResponse.match = NO;
+    });
+    return invalidMatchResponse;
 }
 
 + (instancetype)validMatchResponseWithParameters:(NSDictionary *)parameters
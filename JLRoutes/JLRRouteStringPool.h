@@ -0,0 +1,58 @@
+/*
+ Copyright (c) 2017, Joel Levin
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ 
+ Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ Neither the name of JLRoutes nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import <Foundation/Foundation.h>
+#import "JLRRouteDefinition.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+
+/**
+ JLRRouteStringPool interns the strings of the route definitions registered with a scheme, so that a pattern path
+ component or variable name shared by many routes (like the 'user' and 'userID' of '/user/:userID/…') is only stored once.
+ 
+ A pool only ever grows. It is not thread safe, JLRoutes only uses it while synchronized on the routes controller.
+ */
+
+@interface JLRRouteStringPool : NSObject
+
+/// Returns the pooled string equal to string, adding an immutable copy of it to the pool if there isn't one yet.
+- (NSString *)internedString:(NSString *)string;
+
+/// Returns YES if string is the exact instance that is pooled.
+- (BOOL)containsInternedString:(NSString *)string;
+
+/// The number of distinct strings in the pool.
+@property (nonatomic, assign, readonly) NSUInteger count;
+
+/// An estimate of the bytes used by the pool and the strings in it.
+@property (nonatomic, assign, readonly) NSUInteger estimatedMemoryUsage;
+
+/// Returns an estimate of the bytes used by a string object.
++ (NSUInteger)estimatedMemoryUsageOfString:(NSString *)string;
+
+@end
+
+
+// Lets a routes controller share a route definition's strings with the other routes of its scheme.
+@interface JLRRouteDefinition (JLRRouteStringPool)
+
+// Replaces the definition's pattern, pattern path components, and compiled segment values with their pooled instances.
+- (void)internStringsWithPool:(JLRRouteStringPool *)pool;
+
+// An estimate of the bytes used by the definition, not counting strings that are in pool.
+- (NSUInteger)estimatedMemoryUsageExcludingStringsInPool:(nullable JLRRouteStringPool *)pool;
+
+@end
+
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,74 @@
+/*
+ Copyright (c) 2017, Joel Levin
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ 
+ Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ Neither the name of JLRoutes nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import "JLRRouteStringPool.h"
+
+
+@interface JLRRouteStringPool ()
+
+@property (nonatomic, strong) NSMutableSet <NSString *> *strings;
+@property (nonatomic, assign) NSUInteger estimatedStringsMemoryUsage;
+
+@end
+
+
+@implementation JLRRouteStringPool
+
+- (instancetype)init
+{
+    if ((self = [super init])) {
+        self.strings = [NSMutableSet set];
+    }
+    return self;
+}
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"<%@ %p> - %@ strings, ~%@ bytes", NSStringFromClass([self class]), self, @(self.count), @(self.estimatedMemoryUsage)];
+}
+
+- (NSString *)internedString:(NSString *)string
+{
+    NSString *internedString = [self.strings member:string];
+    
+    if (internedString == nil) {
+        internedString = [string copy];
+        [self.strings addObject:internedString];
+        self.estimatedStringsMemoryUsage += [[self class] estimatedMemoryUsageOfString:internedString];
+    }
+    
+    return internedString;
+}
+
+- (BOOL)containsInternedString:(NSString *)string
+{
+    return string != nil && [self.strings member:string] == string;
+}
+
+- (NSUInteger)count
+{
+    return self.strings.count;
+}
+
+- (NSUInteger)estimatedMemoryUsage
+{
+    // the set's hash table holds roughly two pointers per string
+    return self.estimatedStringsMemoryUsage + self.strings.count * 2 * sizeof(void *);
+}
+
++ (NSUInteger)estimatedMemoryUsageOfString:(NSString *)string
+{
+    // an object header and length, plus the characters themselves (which are stored as UTF-8 when they're ASCII)
+    return 2 * sizeof(void *) + [string lengthOfBytesUsingEncoding:NSUTF8StringEncoding];
+}
+
+@end
@@ -0,0 +1,91 @@
+/*
+ Copyright (c) 2017, Joel Levin
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ 
+ Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ Neither the name of JLRoutes nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import <Foundation/Foundation.h>
+#import "JLRRouteDefinition.h"
+#import "JLRRouteVariableConstraint.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+
+typedef NS_ENUM(uint8_t, JLRRouteSegmentType) {
+    JLRRouteSegmentTypeLiteral,
+    JLRRouteSegmentTypeVariable,
+    JLRRouteSegmentTypeWildcard,
+};
+
+
+// A compiled pattern path component. The value is the literal to compare against (for literals) or the already
+// parsed variable name (for variables), and is retained by the definition's segmentValues array. Variables written
+// as ':name<constraint>' also have a constraint, which is retained by the definition's segmentConstraints array.
+typedef struct {
+    JLRRouteSegmentType type;
+    __unsafe_unretained NSString *_Nullable value;
+    __unsafe_unretained JLRRouteVariableConstraint *_Nullable constraint;
+} JLRRouteSegment;
+
+
+// A run of compiled segments that are matched or skipped together. Only patterns with optional '( … )' groups have these.
+typedef struct {
+    NSUInteger location;
+    NSUInteger length;
+    BOOL optional;
+} JLRRouteSegmentGroup;
+
+
+// Access to a route definition's compiled pattern, so it can be stored in a route table file and restored without parsing.
+@interface JLRRouteDefinition (JLRRouteTable)
+
+@property (nonatomic, assign, readonly) const JLRRouteSegment *compiledSegments;
+@property (nonatomic, assign, readonly) NSUInteger compiledSegmentCount;
+@property (nonatomic, assign, readonly, nullable) const JLRRouteSegmentGroup *compiledSegmentGroups;
+@property (nonatomic, assign, readonly) NSUInteger compiledSegmentGroupCount;
+@property (nonatomic, assign, readonly) NSUInteger minimumPathComponentCount;
+@property (nonatomic, assign, readonly) NSUInteger maximumPathComponentCount;
+
+// Calls block with each combination of the optional groups, as the segments of a pattern without any groups (and without the trailing
+// wildcard, if there is one). Returns NO without calling block if there are too many optional groups to go through every combination.
+- (BOOL)enumerateCompiledPatternsUsingBlock:(void (^)(const JLRRouteSegment *segments, NSUInteger count, BOOL endsWithWildcard))block;
+
+// Creates a route definition from a pattern that was already compiled by -initWithPattern:priority:handlerBlock:. The segments and groups are copied.
+- (instancetype)initWithPattern:(NSString *)pattern priority:(NSUInteger)priority handlerBlock:(nullable BOOL (^)(NSDictionary *parameters))handlerBlock patternPathComponents:(NSArray <NSString *> *)patternPathComponents leadingRequiredPathComponentCount:(NSUInteger)leadingRequiredPathComponentCount segments:(const JLRRouteSegment *)segments segmentCount:(NSUInteger)segmentCount groups:(nullable const JLRRouteSegmentGroup *)groups groupCount:(NSUInteger)groupCount minimumPathComponentCount:(NSUInteger)minimumPathComponentCount maximumPathComponentCount:(NSUInteger)maximumPathComponentCount;
+
+@end
+
+
+/**
+ JLRRouteTable reads and writes route table files, which store a list of routes with their patterns already compiled.
+ 
+ A file starts with a fixed header (magic number, format version, checksum, and section sizes), followed by a table of
+ unique strings and fixed-size records for routes, pattern path components, segments, and optional groups. Routes are
+ stored in the order they are tried in, so loading them doesn't need to parse patterns or sort by priority.
+ 
+ Files are read by memory-mapping them. A file that is truncated, fails its checksum, or refers to anything out of bounds
+ is reported as JLRRouteTableErrorCorruptFile. A file written by a different format version, or for a different
+ fingerprint, is reported as JLRRouteTableErrorStaleFile.
+ */
+
+@interface JLRRouteTable : NSObject
+
+// Returns the route table file contents for routes, or nil if any of them is not a plain JLRRouteDefinition.
++ (nullable NSData *)dataWithRoutes:(NSArray <JLRRouteDefinition *> *)routes fingerprint:(NSString *)fingerprint error:(NSError **)error;
+
+// Returns the routes stored in the route table file at fileURL, with handler blocks from handlerProvider, or nil if it can't be used.
++ (nullable NSArray <JLRRouteDefinition *> *)routesWithContentsOfURL:(NSURL *)fileURL fingerprint:(NSString *)fingerprint handlerProvider:(BOOL (^ _Nullable (^)(NSString *pattern))(NSDictionary<NSString *, id> *parameters))handlerProvider error:(NSError **)error;
+
+// Returns the routes stored in data, which has the contents of a route table file.
++ (nullable NSArray <JLRRouteDefinition *> *)routesWithData:(NSData *)data fingerprint:(NSString *)fingerprint handlerProvider:(BOOL (^ _Nullable (^)(NSString *pattern))(NSDictionary<NSString *, id> *parameters))handlerProvider error:(NSError **)error;
+
+@end
+
+
+NS_ASSUME_NONNULL_END
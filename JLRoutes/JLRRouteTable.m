@@ -0,0 +1,399 @@
+/*
+ Copyright (c) 2017, Joel Levin
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ 
+ Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ Neither the name of JLRoutes nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import "JLRRouteTable.h"
+#import "JLRoutes.h"
+
+
+NSString *const JLRRouteTableErrorDomain = @"JLRRouteTableErrorDomain";
+
+
+// 'JLRT' in a little endian file. Reading it back any other way means the file isn't a route table for this architecture.
+static const uint32_t JLRRouteTableMagic = 0x54524C4A;
+
+// Bump this whenever the file layout or the meaning of the compiled pattern changes.
+static const uint32_t JLRRouteTableFormatVersion = 2;
+
+// Stands in for a string table index where there is no string, such as the value of a wildcard segment.
+static const uint32_t JLRRouteTableNoString = UINT32_MAX;
+
+
+typedef struct {
+    uint32_t magic;
+    uint32_t formatVersion;
+    uint64_t checksum;
+    uint32_t fingerprint;
+    uint32_t stringCount;
+    uint32_t stringBytesLength;
+    uint32_t routeCount;
+    uint32_t componentCount;
+    uint32_t segmentCount;
+    uint32_t groupCount;
+    uint32_t reserved;
+} JLRRouteTableHeader;
+
+
+typedef struct {
+    uint64_t priority;
+    uint64_t maximumPathComponentCount;
+    uint32_t pattern;
+    uint32_t componentLocation;
+    uint32_t componentCount;
+    uint32_t leadingRequiredPathComponentCount;
+    uint32_t segmentLocation;
+    uint32_t segmentCount;
+    uint32_t groupLocation;
+    uint32_t groupCount;
+    uint32_t minimumPathComponentCount;
+    uint32_t reserved;
+} JLRRouteTableRoute;
+
+
+typedef struct {
+    uint32_t type;
+    uint32_t value;
+    uint32_t constraint;
+} JLRRouteTableSegment;
+
+
+typedef struct {
+    uint32_t location;
+    uint32_t length;
+    uint32_t optional;
+} JLRRouteTableGroup;
+
+
+// FNV-1a, which is plenty to catch truncated or damaged files.
+static uint64_t JLRRouteTableChecksum(const uint8_t *bytes, NSUInteger length)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    for (NSUInteger index = 0; index < length; index++) {
+        hash ^= bytes[index];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+
+static NSError *JLRRouteTableError(JLRRouteTableErrorCode code, NSString *description)
+{
+    return [NSError errorWithDomain:JLRRouteTableErrorDomain code:code userInfo:@{NSLocalizedDescriptionKey: description}];
+}
+
+
+@implementation JLRRouteTable
+
+#pragma mark - Writing
+
++ (NSData *)dataWithRoutes:(NSArray <JLRRouteDefinition *> *)routes fingerprint:(NSString *)fingerprint error:(NSError **)error
+{
+    NSMutableArray <NSString *> *strings = [NSMutableArray array];
+    NSMutableDictionary <NSString *, NSNumber *> *stringIndexes = [NSMutableDictionary dictionary];
+    
+    uint32_t (^indexOfString)(NSString *) = ^uint32_t (NSString *string) {
+        if (string == nil) {
+            return JLRRouteTableNoString;
+        }
+        
+        NSNumber *index = stringIndexes[string];
+        if (index == nil) {
+            index = @(strings.count);
+            stringIndexes[string] = index;
+            [strings addObject:string];
+        }
+        return (uint32_t)index.unsignedIntegerValue;
+    };
+    
+    JLRRouteTableHeader header = {0};
+    header.magic = JLRRouteTableMagic;
+    header.formatVersion = JLRRouteTableFormatVersion;
+    header.fingerprint = indexOfString(fingerprint);
+    
+    NSMutableData *routeData = [NSMutableData data];
+    NSMutableData *componentData = [NSMutableData data];
+    NSMutableData *segmentData = [NSMutableData data];
+    NSMutableData *groupData = [NSMutableData data];
+    
+    for (JLRRouteDefinition *route in routes) {
+        if ([route class] != [JLRRouteDefinition class]) {
+            // subclasses can parse patterns (and match them) differently, which a route table can't capture
+            if (error != NULL) {
+                *error = JLRRouteTableError(JLRRouteTableErrorUnsupportedRoute, [NSString stringWithFormat:@"%@ is not a JLRRouteDefinition", route]);
+            }
+            return nil;
+        }
+        
+        JLRRouteTableRoute record = {0};
+        record.priority = route.priority;
+        record.maximumPathComponentCount = route.maximumPathComponentCount == NSUIntegerMax ? UINT64_MAX : route.maximumPathComponentCount;
+        record.minimumPathComponentCount = (uint32_t)route.minimumPathComponentCount;
+        record.pattern = indexOfString(route.pattern);
+        record.leadingRequiredPathComponentCount = (uint32_t)route.leadingRequiredPathComponentCount;
+        
+        record.componentLocation = header.componentCount;
+        record.componentCount = (uint32_t)route.patternPathComponents.count;
+        for (NSString *component in route.patternPathComponents) {
+            uint32_t componentIndex = indexOfString(component);
+            [componentData appendBytes:&componentIndex length:sizeof(componentIndex)];
+        }
+        header.componentCount += record.componentCount;
+        
+        record.segmentLocation = header.segmentCount;
+        record.segmentCount = (uint32_t)route.compiledSegmentCount;
+        for (NSUInteger index = 0; index < route.compiledSegmentCount; index++) {
+            JLRRouteSegment segment = route.compiledSegments[index];
+            JLRRouteTableSegment segmentRecord = {segment.type, indexOfString(segment.value), indexOfString(segment.constraint.string)};
+            [segmentData appendBytes:&segmentRecord length:sizeof(segmentRecord)];
+        }
+        header.segmentCount += record.segmentCount;
+        
+        record.groupLocation = header.groupCount;
+        record.groupCount = (uint32_t)route.compiledSegmentGroupCount;
+        for (NSUInteger index = 0; index < route.compiledSegmentGroupCount; index++) {
+            JLRRouteSegmentGroup group = route.compiledSegmentGroups[index];
+            JLRRouteTableGroup groupRecord = {(uint32_t)group.location, (uint32_t)group.length, group.optional ? 1 : 0};
+            [groupData appendBytes:&groupRecord length:sizeof(groupRecord)];
+        }
+        header.groupCount += record.groupCount;
+        
+        [routeData appendBytes:&record length:sizeof(record)];
+        header.routeCount++;
+    }
+    
+    // the string table is an offset for each string (plus the end offset), followed by all of their UTF-8 bytes
+    NSMutableData *stringOffsetData = [NSMutableData dataWithCapacity:(strings.count + 1) * sizeof(uint32_t)];
+    NSMutableData *stringData = [NSMutableData data];
+    
+    for (NSString *string in strings) {
+        uint32_t offset = (uint32_t)stringData.length;
+        [stringOffsetData appendBytes:&offset length:sizeof(offset)];
+        [stringData appendData:[string dataUsingEncoding:NSUTF8StringEncoding]];
+    }
+    
+    uint32_t endOffset = (uint32_t)stringData.length;
+    [stringOffsetData appendBytes:&endOffset length:sizeof(endOffset)];
+    
+    header.stringCount = (uint32_t)strings.count;
+    header.stringBytesLength = (uint32_t)stringData.length;
+    
+    NSMutableData *data = [NSMutableData dataWithLength:sizeof(header)];
+    for (NSData *section in @[stringOffsetData, stringData, routeData, componentData, segmentData, groupData]) {
+        [data appendData:section];
+    }
+    
+    header.checksum = JLRRouteTableChecksum((const uint8_t *)data.bytes + sizeof(header), data.length - sizeof(header));
+    [data replaceBytesInRange:NSMakeRange(0, sizeof(header)) withBytes:&header];
+    
+    return [data copy];
+}
+
+#pragma mark - Reading
+
++ (NSArray <JLRRouteDefinition *> *)routesWithContentsOfURL:(NSURL *)fileURL fingerprint:(NSString *)fingerprint handlerProvider:(BOOL (^ _Nullable (^)(NSString *pattern))(NSDictionary<NSString *, id> *parameters))handlerProvider error:(NSError **)error
+{
+    NSData *data = [NSData dataWithContentsOfURL:fileURL options:NSDataReadingMappedAlways error:error];
+    
+    if (data == nil) {
+        return nil;
+    }
+    
+    return [self routesWithData:data fingerprint:fingerprint handlerProvider:handlerProvider error:error];
+}
+
++ (NSArray <JLRRouteDefinition *> *)routesWithData:(NSData *)data fingerprint:(NSString *)fingerprint handlerProvider:(BOOL (^ _Nullable (^)(NSString *pattern))(NSDictionary<NSString *, id> *parameters))handlerProvider error:(NSError **)error
+{
+    const uint8_t *bytes = data.bytes;
+    NSUInteger length = data.length;
+    JLRRouteTableHeader header;
+    
+    if (length < sizeof(header)) {
+        return [self _failWithError:error code:JLRRouteTableErrorCorruptFile description:@"The route table is truncated."];
+    }
+    
+    memcpy(&header, bytes, sizeof(header));
+    
+    if (header.magic != JLRRouteTableMagic) {
+        return [self _failWithError:error code:JLRRouteTableErrorCorruptFile description:@"The file is not a route table."];
+    }
+    
+    if (header.formatVersion != JLRRouteTableFormatVersion) {
+        return [self _failWithError:error code:JLRRouteTableErrorStaleFile description:@"The route table was written by a different version of JLRoutes."];
+    }
+    
+    // section sizes are computed in 64 bits, so huge counts in a damaged header can't wrap around
+    uint64_t stringOffsetsLength = ((uint64_t)header.stringCount + 1) * sizeof(uint32_t);
+    uint64_t routesLength = (uint64_t)header.routeCount * sizeof(JLRRouteTableRoute);
+    uint64_t componentsLength = (uint64_t)header.componentCount * sizeof(uint32_t);
+    uint64_t segmentsLength = (uint64_t)header.segmentCount * sizeof(JLRRouteTableSegment);
+    uint64_t groupsLength = (uint64_t)header.groupCount * sizeof(JLRRouteTableGroup);
+    uint64_t expectedLength = sizeof(header) + stringOffsetsLength + header.stringBytesLength + routesLength + componentsLength + segmentsLength + groupsLength;
+    
+    if (expectedLength != length || header.checksum != JLRRouteTableChecksum(bytes + sizeof(header), length - sizeof(header))) {
+        return [self _failWithError:error code:JLRRouteTableErrorCorruptFile description:@"The route table is damaged."];
+    }
+    
+    const uint8_t *stringOffsets = bytes + sizeof(header);
+    const uint8_t *stringBytes = stringOffsets + stringOffsetsLength;
+    const uint8_t *routeRecords = stringBytes + header.stringBytesLength;
+    const uint8_t *componentRecords = routeRecords + routesLength;
+    const uint8_t *segmentRecords = componentRecords + componentsLength;
+    const uint8_t *groupRecords = segmentRecords + segmentsLength;
+    
+    // every string is created once, and shared by all of the routes that use it
+    NSMutableArray <NSString *> *strings = [NSMutableArray arrayWithCapacity:header.stringCount];
+    uint32_t startOffset = 0;
+    memcpy(&startOffset, stringOffsets, sizeof(startOffset));
+    
+    for (uint32_t index = 0; index < header.stringCount; index++) {
+        uint32_t endOffset = 0;
+        memcpy(&endOffset, stringOffsets + (index + 1) * sizeof(uint32_t), sizeof(endOffset));
+        
+        NSString *string = nil;
+        if (startOffset <= endOffset && endOffset <= header.stringBytesLength) {
+            string = [[NSString alloc] initWithBytes:stringBytes + startOffset length:endOffset - startOffset encoding:NSUTF8StringEncoding];
+        }
+        
+        if (string == nil) {
+            return [self _failWithError:error code:JLRRouteTableErrorCorruptFile description:@"The route table has an invalid string."];
+        }
+        
+        [strings addObject:string];
+        startOffset = endOffset;
+    }
+    
+    if (header.fingerprint >= header.stringCount || ![strings[header.fingerprint] isEqualToString:fingerprint]) {
+        return [self _failWithError:error code:JLRRouteTableErrorStaleFile description:@"The route table was written for a different set of routes."];
+    }
+    
+    NSMutableArray <JLRRouteDefinition *> *routes = [NSMutableArray arrayWithCapacity:header.routeCount];
+    
+    // constraints are only written as their text, and routes that share one share the parsed constraint. This also keeps
+    // them alive until the routes retain them, since segments don't.
+    NSMutableDictionary <NSString *, JLRRouteVariableConstraint *> *constraints = [NSMutableDictionary dictionary];
+    
+    for (uint32_t routeIndex = 0; routeIndex < header.routeCount; routeIndex++) {
+        JLRRouteTableRoute record;
+        memcpy(&record, routeRecords + routeIndex * sizeof(record), sizeof(record));
+        
+        if (![self _isValidRouteRecord:record header:header]) {
+            return [self _failWithError:error code:JLRRouteTableErrorCorruptFile description:@"The route table has an invalid route."];
+        }
+        
+        NSMutableArray <NSString *> *patternPathComponents = [NSMutableArray arrayWithCapacity:record.componentCount];
+        for (uint32_t index = 0; index < record.componentCount; index++) {
+            uint32_t stringIndex = 0;
+            memcpy(&stringIndex, componentRecords + (record.componentLocation + index) * sizeof(uint32_t), sizeof(stringIndex));
+            
+            if (stringIndex >= header.stringCount) {
+                return [self _failWithError:error code:JLRRouteTableErrorCorruptFile description:@"The route table has an invalid route."];
+            }
+            [patternPathComponents addObject:strings[stringIndex]];
+        }
+        
+        JLRRouteSegment *segments = calloc(MAX(record.segmentCount, 1U), sizeof(JLRRouteSegment));
+        JLRRouteSegmentGroup *groups = calloc(MAX(record.groupCount, 1U), sizeof(JLRRouteSegmentGroup));
+        BOOL isValid = YES;
+        
+        for (uint32_t index = 0; index < record.segmentCount && isValid; index++) {
+            JLRRouteTableSegment segmentRecord;
+            memcpy(&segmentRecord, segmentRecords + (record.segmentLocation + index) * sizeof(segmentRecord), sizeof(segmentRecord));
+            
+            // only wildcards have no value, and they always end the compiled pattern. Only variables have constraints.
+            BOOL isWildcard = (segmentRecord.type == JLRRouteSegmentTypeWildcard);
+            BOOL hasConstraint = (segmentRecord.constraint != JLRRouteTableNoString);
+            isValid = (segmentRecord.type <= JLRRouteSegmentTypeWildcard) && (isWildcard ? (segmentRecord.value == JLRRouteTableNoString && index == record.segmentCount - 1) : segmentRecord.value < header.stringCount);
+            isValid = isValid && (!hasConstraint || (segmentRecord.type == JLRRouteSegmentTypeVariable && segmentRecord.constraint < header.stringCount));
+            
+            segments[index].type = (JLRRouteSegmentType)segmentRecord.type;
+            segments[index].value = isValid && !isWildcard ? strings[segmentRecord.value] : nil;
+            
+            if (isValid && hasConstraint) {
+                NSString *constraintString = strings[segmentRecord.constraint];
+                if (constraints[constraintString] == nil) {
+                    constraints[constraintString] = [JLRRouteVariableConstraint constraintWithString:constraintString];
+                }
+                segments[index].constraint = constraints[constraintString];
+            }
+        }
+        
+        if (isValid && record.groupCount == 0) {
+            // without groups, the path component counts are what matching relies on to stay within the segments
+            BOOL endsWithWildcard = (record.segmentCount > 0 && segments[record.segmentCount - 1].type == JLRRouteSegmentTypeWildcard);
+            uint32_t matchedCount = endsWithWildcard ? record.segmentCount - 1 : record.segmentCount;
+            isValid = (record.minimumPathComponentCount == matchedCount && record.maximumPathComponentCount == (endsWithWildcard ? UINT64_MAX : matchedCount));
+        }
+        
+        for (uint32_t index = 0; index < record.groupCount && isValid; index++) {
+            JLRRouteTableGroup groupRecord;
+            memcpy(&groupRecord, groupRecords + (record.groupLocation + index) * sizeof(groupRecord), sizeof(groupRecord));
+            
+            isValid = (groupRecord.location <= record.segmentCount && groupRecord.length <= record.segmentCount - groupRecord.location);
+            
+            groups[index].location = groupRecord.location;
+            groups[index].length = groupRecord.length;
+            groups[index].optional = groupRecord.optional != 0;
+        }
+        
+        JLRRouteDefinition *route = nil;
+        
+        if (isValid) {
+            NSString *pattern = strings[record.pattern];
+            NSUInteger maximumPathComponentCount = record.maximumPathComponentCount == UINT64_MAX ? NSUIntegerMax : (NSUInteger)record.maximumPathComponentCount;
+            
+            route = [[JLRRouteDefinition alloc] initWithPattern:pattern priority:(NSUInteger)record.priority handlerBlock:handlerProvider(pattern) patternPathComponents:patternPathComponents leadingRequiredPathComponentCount:record.leadingRequiredPathComponentCount segments:segments segmentCount:record.segmentCount groups:groups groupCount:record.groupCount minimumPathComponentCount:record.minimumPathComponentCount maximumPathComponentCount:maximumPathComponentCount];
+        }
+        
+        free(segments);
+        free(groups);
+        
+        if (route == nil) {
+            return [self _failWithError:error code:JLRRouteTableErrorCorruptFile description:@"The route table has an invalid route."];
+        }
+        
+        [routes addObject:route];
+    }
+    
+    return [routes copy];
+}
+
+#pragma mark - Private
+
++ (BOOL)_isValidRouteRecord:(JLRRouteTableRoute)record header:(JLRRouteTableHeader)header
+{
+    if (record.pattern >= header.stringCount) {
+        return NO;
+    }
+    
+    if (record.componentLocation > header.componentCount || record.componentCount > header.componentCount - record.componentLocation) {
+        return NO;
+    }
+    
+    if (record.segmentLocation > header.segmentCount || record.segmentCount > header.segmentCount - record.segmentLocation) {
+        return NO;
+    }
+    
+    if (record.groupLocation > header.groupCount || record.groupCount > header.groupCount - record.groupLocation) {
+        return NO;
+    }
+    
+    return record.leadingRequiredPathComponentCount <= record.componentCount && record.minimumPathComponentCount <= record.segmentCount;
+}
+
++ (id)_failWithError:(NSError **)error code:(JLRRouteTableErrorCode)code description:(NSString *)description
+{
+    if (error != NULL) {
+        *error = JLRRouteTableError(code, description);
+    }
+    return nil;
+}
+
+@end
@@ -0,0 +1,76 @@
+/*
+ Copyright (c) 2017, Joel Levin
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ 
+ Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ Neither the name of JLRoutes nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import <Foundation/Foundation.h>
+
+@class JLRRouteRequest;
+
+NS_ASSUME_NONNULL_BEGIN
+
+
+/// The kinds of values a constrained route variable accepts.
+typedef NS_ENUM(NSUInteger, JLRRouteVariableConstraintType) {
+    /// ':id<int>' accepts decimal integers (with an optional leading '-') that fit in a long long, delivered as an NSNumber.
+    JLRRouteVariableConstraintTypeInteger,
+    
+    /// ':id<uuid>' accepts UUIDs like 'E621E1F8-C36C-495A-93FC-0C247A3E6E5F', in either case, delivered as an NSUUID.
+    JLRRouteVariableConstraintTypeUUID,
+    
+    /// ':code<2..8>' accepts strings of 2 to 8 characters. Either bound can be left out, as in ':code<..8>' or ':code<2..>'.
+    JLRRouteVariableConstraintTypeLength,
+    
+    /// ':tab<home|feed|settings>' accepts exactly one of the listed strings.
+    JLRRouteVariableConstraintTypeEnumeration,
+};
+
+
+/**
+ JLRRouteVariableConstraint restricts the values a route variable matches, as written between '<' and '>' after its name.
+ 
+ Constraints are checked against the decoded value of the path component while the route is matched, so a route
+ whose variable doesn't accept a path component is skipped without creating its parameters. Accepted values are
+ delivered in the parameters dictionary already converted, for the types that have a conversion.
+ */
+
+@interface JLRRouteVariableConstraint : NSObject <NSCopying>
+
+/// Returns the constraint written as string, the text between '<' and '>'. Anything that isn't 'int', 'uuid', or a length range is a list of strings separated by '|'.
++ (instancetype)constraintWithString:(NSString *)string;
+
+/// Unavailable, use +constraintWithString: instead.
+- (instancetype)init NS_UNAVAILABLE;
+
+/// Unavailable, use +constraintWithString: instead.
++ (instancetype)new NS_UNAVAILABLE;
+
+/// The text the constraint was created from. Two constraints are equal if they have the same string.
+@property (nonatomic, copy, readonly) NSString *string;
+
+/// The kind of values the constraint accepts.
+@property (nonatomic, assign, readonly) JLRRouteVariableConstraintType type;
+
+/// Returns the value to deliver for a route variable, or nil if the constraint doesn't accept it.
+- (nullable id)valueForString:(NSString *)string;
+
+/// Returns YES if the constraint accepts the path component at index, decoded just like the value of a route variable.
+- (BOOL)allowsPathComponentAtIndex:(NSUInteger)index ofRequest:(JLRRouteRequest *)request;
+
+/// Returns YES if the constraint accepts the pattern literal literal, however plus symbols are decoded. For analyzing patterns.
+- (BOOL)allowsEveryValueOfLiteral:(NSString *)literal;
+
+/// Returns YES if the constraint may accept the pattern literal literal, depending on how plus symbols are decoded. For analyzing patterns.
+- (BOOL)mayAllowValueOfLiteral:(NSString *)literal;
+
+@end
+
+
+NS_ASSUME_NONNULL_END
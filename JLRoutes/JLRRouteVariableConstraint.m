@@ -0,0 +1,280 @@
+/*
+ Copyright (c) 2017, Joel Levin
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ 
+ Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ Neither the name of JLRoutes nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import "JLRRouteVariableConstraint.h"
+#import "JLRParsingUtilities.h"
+#import "JLRRouteRequest.h"
+
+
+static BOOL JLRRouteVariableConstraintIsHexDigit(char character)
+{
+    return (character >= '0' && character <= '9') || (character >= 'a' && character <= 'f') || (character >= 'A' && character <= 'F');
+}
+
+// Parses a decimal long long, failing on anything else (including overflow) instead of stopping at the first bad character.
+static BOOL JLRRouteVariableConstraintParseInteger(const char *bytes, NSUInteger length, long long *value)
+{
+    BOOL negative = (length > 0 && bytes[0] == '-');
+    NSUInteger index = negative ? 1 : 0;
+    unsigned long long magnitude = 0;
+    unsigned long long limit = negative ? (unsigned long long)LLONG_MAX + 1 : (unsigned long long)LLONG_MAX;
+    
+    if (index == length) {
+        return NO;
+    }
+    
+    for (; index < length; index++) {
+        if (bytes[index] < '0' || bytes[index] > '9') {
+            return NO;
+        }
+        
+        unsigned long long digit = (unsigned long long)(bytes[index] - '0');
+        if (magnitude > (limit - digit) / 10) {
+            return NO;
+        }
+        magnitude = magnitude * 10 + digit;
+    }
+    
+    if (value != NULL) {
+        *value = negative ? (long long)(0 - magnitude) : (long long)magnitude;
+    }
+    return YES;
+}
+
+static BOOL JLRRouteVariableConstraintIsUUID(const char *bytes, NSUInteger length)
+{
+    if (length != 36) {
+        return NO;
+    }
+    
+    for (NSUInteger index = 0; index < length; index++) {
+        BOOL isSeparator = (index == 8 || index == 13 || index == 18 || index == 23);
+        if (isSeparator ? bytes[index] != '-' : !JLRRouteVariableConstraintIsHexDigit(bytes[index])) {
+            return NO;
+        }
+    }
+    
+    return YES;
+}
+
+// The length NSString would report for UTF-8 bytes, without creating one: one per character, two for those outside the BMP.
+static NSUInteger JLRRouteVariableConstraintUTF16Length(const char *bytes, NSUInteger length)
+{
+    NSUInteger UTF16Length = 0;
+    
+    for (NSUInteger index = 0; index < length; index++) {
+        uint8_t byte = (uint8_t)bytes[index];
+        if ((byte & 0xc0) != 0x80) {
+            UTF16Length += (byte >= 0xf0) ? 2 : 1;
+        }
+    }
+    
+    return UTF16Length;
+}
+
+
+@interface JLRRouteVariableConstraint ()
+
+@property (nonatomic, copy) NSString *string;
+@property (nonatomic, assign) JLRRouteVariableConstraintType type;
+@property (nonatomic, assign) NSUInteger minimumLength;
+@property (nonatomic, assign) NSUInteger maximumLength;
+@property (nonatomic, copy) NSSet <NSString *> *allowedValues;
+
+@end
+
+
+@implementation JLRRouteVariableConstraint
+
++ (instancetype)constraintWithString:(NSString *)string
+{
+    return [[self alloc] _initWithString:string];
+}
+
+- (instancetype)_initWithString:(NSString *)string
+{
+    if ((self = [super init])) {
+        self.string = string;
+        
+        NSRange rangeSeparator = [string rangeOfString:@".."];
+        
+        if ([string isEqualToString:@"int"]) {
+            self.type = JLRRouteVariableConstraintTypeInteger;
+        } else if ([string isEqualToString:@"uuid"]) {
+            self.type = JLRRouteVariableConstraintTypeUUID;
+        } else if (rangeSeparator.location != NSNotFound && [self _parseLengthRangeFromString:string separatorRange:rangeSeparator]) {
+            self.type = JLRRouteVariableConstraintTypeLength;
+        } else {
+            self.type = JLRRouteVariableConstraintTypeEnumeration;
+            self.allowedValues = [NSSet setWithArray:[string componentsSeparatedByString:@"|"]];
+        }
+    }
+    return self;
+}
+
+- (BOOL)_parseLengthRangeFromString:(NSString *)string separatorRange:(NSRange)separatorRange
+{
+    const char *minimumBytes = [string substringToIndex:separatorRange.location].UTF8String;
+    const char *maximumBytes = [string substringFromIndex:NSMaxRange(separatorRange)].UTF8String;
+    long long minimumLength = 0;
+    long long maximumLength = LLONG_MAX;
+    
+    if ((strlen(minimumBytes) > 0 && !JLRRouteVariableConstraintParseInteger(minimumBytes, strlen(minimumBytes), &minimumLength)) || (strlen(maximumBytes) > 0 && !JLRRouteVariableConstraintParseInteger(maximumBytes, strlen(maximumBytes), &maximumLength))) {
+        return NO;
+    }
+    
+    if (minimumLength < 0 || maximumLength < minimumLength) {
+        return NO;
+    }
+    
+    self.minimumLength = (NSUInteger)minimumLength;
+    self.maximumLength = (maximumLength == LLONG_MAX) ? NSUIntegerMax : (NSUInteger)maximumLength;
+    return YES;
+}
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"<%@ %p> - <%@>", NSStringFromClass([self class]), self, self.string];
+}
+
+- (BOOL)isEqual:(id)object
+{
+    if (object == self) {
+        return YES;
+    }
+    
+    return [object isKindOfClass:[JLRRouteVariableConstraint class]] && [self.string isEqualToString:((JLRRouteVariableConstraint *)object).string];
+}
+
+- (NSUInteger)hash
+{
+    return self.string.hash;
+}
+
+- (id)copyWithZone:(NSZone *)zone
+{
+    // constraints are immutable
+    return self;
+}
+
+#pragma mark - Checking Values
+
+- (id)valueForString:(NSString *)string
+{
+    if (string == nil) {
+        return nil;
+    }
+    
+    switch (self.type) {
+        case JLRRouteVariableConstraintTypeInteger: {
+            const char *bytes = string.UTF8String ?: "";
+            long long value = 0;
+            return JLRRouteVariableConstraintParseInteger(bytes, strlen(bytes), &value) ? @(value) : nil;
+        }
+            
+        case JLRRouteVariableConstraintTypeUUID: {
+            const char *bytes = string.UTF8String ?: "";
+            return JLRRouteVariableConstraintIsUUID(bytes, strlen(bytes)) ? [[NSUUID alloc] initWithUUIDString:string] : nil;
+        }
+            
+        case JLRRouteVariableConstraintTypeLength:
+            return (string.length >= self.minimumLength && string.length <= self.maximumLength) ? string : nil;
+            
+        case JLRRouteVariableConstraintTypeEnumeration:
+            return [self.allowedValues containsObject:string] ? string : nil;
+    }
+    
+    return nil;
+}
+
+- (BOOL)allowsPathComponentAtIndex:(NSUInteger)index ofRequest:(JLRRouteRequest *)request
+{
+    NSUInteger length = 0;
+    const char *bytes = [request UTF8StringForPathComponentAtIndex:index length:&length];
+    
+    for (NSUInteger byteIndex = 0; byteIndex < length; byteIndex++) {
+        if (bytes[byteIndex] == '%' || bytes[byteIndex] == '+' || bytes[byteIndex] == '#') {
+            // the value differs from the raw bytes, so decode it the same way route variables are
+            BOOL decodePlusSymbols = ((request.options & JLRRouteRequestOptionDecodePlusSymbols) == JLRRouteRequestOptionDecodePlusSymbols);
+            NSString *value = [JLRParsingUtilities stringByDecodingUTF8Bytes:bytes length:length removePercentEncoding:YES decodePlusSymbols:decodePlusSymbols];
+            return [self valueForString:[self _valueByStrippingFragment:value]] != nil;
+        }
+    }
+    
+    // otherwise the raw bytes are the value, which is checked in place
+    switch (self.type) {
+        case JLRRouteVariableConstraintTypeInteger:
+            return JLRRouteVariableConstraintParseInteger(bytes, length, NULL);
+            
+        case JLRRouteVariableConstraintTypeUUID:
+            return JLRRouteVariableConstraintIsUUID(bytes, length);
+            
+        case JLRRouteVariableConstraintTypeLength: {
+            NSUInteger UTF16Length = JLRRouteVariableConstraintUTF16Length(bytes, length);
+            return UTF16Length >= self.minimumLength && UTF16Length <= self.maximumLength;
+        }
+            
+        case JLRRouteVariableConstraintTypeEnumeration: {
+            NSString *value = [[NSString alloc] initWithBytes:bytes length:length encoding:NSUTF8StringEncoding];
+            return value != nil && [self.allowedValues containsObject:value];
+        }
+    }
+    
+    return NO;
+}
+
+- (BOOL)allowsEveryValueOfLiteral:(NSString *)literal
+{
+    for (NSString *value in [self _valuesOfLiteral:literal]) {
+        if ([value isKindOfClass:[NSNull class]] || [self valueForString:value] == nil) {
+            return NO;
+        }
+    }
+    return YES;
+}
+
+- (BOOL)mayAllowValueOfLiteral:(NSString *)literal
+{
+    for (NSString *value in [self _valuesOfLiteral:literal]) {
+        if ([value isKindOfClass:[NSNull class]] || [self valueForString:value] != nil) {
+            return YES;
+        }
+    }
+    return NO;
+}
+
+#pragma mark - Private
+
+- (NSArray *)_valuesOfLiteral:(NSString *)literal
+{
+    // a literal matches the path component with the same bytes, whose value depends on whether plus symbols are decoded.
+    // NSNull stands in for a value that doesn't decode, which can't be known to be accepted or not.
+    NSMutableArray *values = [NSMutableArray arrayWithCapacity:2];
+    
+    for (NSNumber *decodePlusSymbols in @[@NO, @YES]) {
+        NSString *value = [JLRParsingUtilities stringByDecodingString:literal removePercentEncoding:YES decodePlusSymbols:decodePlusSymbols.boolValue];
+        [values addObject:[self _valueByStrippingFragment:value] ?: [NSNull null]];
+    }
+    
+    return values;
+}
+
+- (NSString *)_valueByStrippingFragment:(NSString *)value
+{
+    // the same trailing fragment JLRRouteDefinition strips from route variable values
+    if (value.length > 1 && [value characterAtIndex:value.length - 1] == '#') {
+        return [value substringToIndex:value.length - 1];
+    }
+    return value;
+}
+
+@end
@@ -0,0 +1,47 @@
+/*
+ Copyright (c) 2017, Joel Levin
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ 
+ Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ Neither the name of JLRoutes nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import <Foundation/Foundation.h>
+
+@class JLRRouteDefinition;
+
+NS_ASSUME_NONNULL_BEGIN
+
+
+/**
+ JLRShadowedRoute describes a route that is never the first match for any URL, because every URL it matches is also
+ matched by routes that are tried before it. A shadowed route is only reached if the handler blocks of those routes
+ return NO.
+ 
+ Routes are compared by their compiled patterns, so only routes that are matched by their pattern alone are analyzed.
+ Instances of JLRRouteDefinition subclasses that override -routeResponseForRequest: or -routeVariablesForRequest: are
+ never reported as shadowed, and are never considered to shadow other routes.
+ */
+
+@interface JLRShadowedRoute : NSObject
+
+/// The shadowed route.
+@property (nonatomic, strong, readonly) JLRRouteDefinition *route;
+
+/// The earlier routes that together match every URL route matches, in the order they are tried.
+@property (nonatomic, copy, readonly) NSArray <JLRRouteDefinition *> *shadowingRoutes;
+
+/// YES if route matches exactly the same URLs as a single earlier route (for example, the same pattern registered twice).
+@property (nonatomic, assign, readonly, getter=isDuplicate) BOOL duplicate;
+
+/// Returns the shadowed routes among routes, which must be in the order they are tried in.
++ (NSArray <JLRShadowedRoute *> *)shadowedRoutesInRoutes:(NSArray <JLRRouteDefinition *> *)routes;
+
+@end
+
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,212 @@
+/*
+ Copyright (c) 2017, Joel Levin
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ 
+ Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+ Neither the name of JLRoutes nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import "JLRShadowedRoute.h"
+#import "JLRRouteDefinition.h"
+#import "JLRRouteIndex.h"
+#import "JLRRouteTable.h"
+
+
+// A node of a trie over the patterns of the routes checked so far. Each node remembers the index of the first route
+// whose pattern ends there, and of the first whose pattern has a wildcard there. Constrained variables don't match
+// every path component, so they get their own children instead of sharing the variable child.
+@interface JLRShadowingNode : NSObject
+
+@property (nonatomic, strong, nullable) NSMutableDictionary <NSString *, JLRShadowingNode *> *literalChildren;
+@property (nonatomic, strong, nullable) JLRShadowingNode *variableChild;
+@property (nonatomic, strong, nullable) NSMutableDictionary <JLRRouteVariableConstraint *, JLRShadowingNode *> *constrainedChildren;
+@property (nonatomic, assign) NSUInteger terminalRouteIndex;
+@property (nonatomic, assign) NSUInteger wildcardRouteIndex;
+
+@end
+
+
+@implementation JLRShadowingNode
+
+- (instancetype)init
+{
+    if ((self = [super init])) {
+        _terminalRouteIndex = NSNotFound;
+        _wildcardRouteIndex = NSNotFound;
+    }
+    return self;
+}
+
+@end
+
+
+static void JLRShadowingNodeAddPattern(JLRShadowingNode *node, const JLRRouteSegment *segments, NSUInteger count, BOOL endsWithWildcard, NSUInteger routeIndex)
+{
+    for (NSUInteger index = 0; index < count; index++) {
+        JLRShadowingNode *child = nil;
+        
+        if (segments[index].type == JLRRouteSegmentTypeLiteral) {
+            if (node.literalChildren == nil) {
+                node.literalChildren = [NSMutableDictionary dictionary];
+            }
+            child = node.literalChildren[segments[index].value];
+            if (child == nil) {
+                child = [[JLRShadowingNode alloc] init];
+                node.literalChildren[segments[index].value] = child;
+            }
+        } else if (segments[index].constraint != nil) {
+            if (node.constrainedChildren == nil) {
+                node.constrainedChildren = [NSMutableDictionary dictionary];
+            }
+            child = node.constrainedChildren[segments[index].constraint];
+            if (child == nil) {
+                child = [[JLRShadowingNode alloc] init];
+                node.constrainedChildren[segments[index].constraint] = child;
+            }
+        } else {
+            child = node.variableChild;
+            if (child == nil) {
+                child = [[JLRShadowingNode alloc] init];
+                node.variableChild = child;
+            }
+        }
+        
+        node = child;
+    }
+    
+    // routes are added in order, so the first one to end at a node is the one tried first
+    if (endsWithWildcard && node.wildcardRouteIndex == NSNotFound) {
+        node.wildcardRouteIndex = routeIndex;
+    } else if (!endsWithWildcard && node.terminalRouteIndex == NSNotFound) {
+        node.terminalRouteIndex = routeIndex;
+    }
+}
+
+
+// Returns the index of a route in the trie that matches every path the segments match, or NSNotFound if there isn't one.
+// A literal segment is matched by the same literal, by a variable, or by a constrained variable accepting it. A variable
+// segment is only matched by a variable, or by a constrained variable with the same constraint if it has one.
+static NSUInteger JLRShadowingNodeFindRouteIndex(JLRShadowingNode *node, const JLRRouteSegment *segments, NSUInteger count, BOOL endsWithWildcard, NSUInteger depth)
+{
+    if (node == nil) {
+        return NSNotFound;
+    }
+    
+    if (node.wildcardRouteIndex != NSNotFound) {
+        // matches everything from this depth on
+        return node.wildcardRouteIndex;
+    }
+    
+    if (depth == count) {
+        return endsWithWildcard ? NSNotFound : node.terminalRouteIndex;
+    }
+    
+    if (segments[depth].type == JLRRouteSegmentTypeLiteral) {
+        NSUInteger routeIndex = JLRShadowingNodeFindRouteIndex(node.literalChildren[segments[depth].value], segments, count, endsWithWildcard, depth + 1);
+        if (routeIndex != NSNotFound) {
+            return routeIndex;
+        }
+        
+        for (JLRRouteVariableConstraint *constraint in node.constrainedChildren) {
+            if ([constraint allowsEveryValueOfLiteral:segments[depth].value]) {
+                routeIndex = JLRShadowingNodeFindRouteIndex(node.constrainedChildren[constraint], segments, count, endsWithWildcard, depth + 1);
+                if (routeIndex != NSNotFound) {
+                    return routeIndex;
+                }
+            }
+        }
+    } else if (segments[depth].constraint != nil) {
+        NSUInteger routeIndex = JLRShadowingNodeFindRouteIndex(node.constrainedChildren[segments[depth].constraint], segments, count, endsWithWildcard, depth + 1);
+        if (routeIndex != NSNotFound) {
+            return routeIndex;
+        }
+    }
+    
+    return JLRShadowingNodeFindRouteIndex(node.variableChild, segments, count, endsWithWildcard, depth + 1);
+}
+
+
+@interface JLRShadowedRoute ()
+
+@property (nonatomic, strong) JLRRouteDefinition *route;
+@property (nonatomic, copy) NSArray <JLRRouteDefinition *> *shadowingRoutes;
+@property (nonatomic, assign, getter=isDuplicate) BOOL duplicate;
+
+@end
+
+
+@implementation JLRShadowedRoute
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"<%@ %p> - %@ %@ by %@", NSStringFromClass([self class]), self, self.route.pattern, (self.isDuplicate ? @"duplicated" : @"shadowed"), [self.shadowingRoutes valueForKey:@"pattern"]];
+}
+
++ (NSArray <JLRShadowedRoute *> *)shadowedRoutesInRoutes:(NSArray <JLRRouteDefinition *> *)routes
+{
+    JLRShadowingNode *rootNode = [[JLRShadowingNode alloc] init];
+    NSMutableArray <JLRShadowedRoute *> *shadowedRoutes = [NSMutableArray array];
+    
+    [routes enumerateObjectsUsingBlock:^(JLRRouteDefinition *route, NSUInteger routeIndex, BOOL *stop) {
+        if (![JLRRouteIndex canIndexRoute:route]) {
+            return;
+        }
+        
+        NSMutableIndexSet *shadowingRouteIndexes = [NSMutableIndexSet indexSet];
+        __block BOOL shadowed = YES;
+        
+        BOOL checked = [route enumerateCompiledPatternsUsingBlock:^(const JLRRouteSegment *segments, NSUInteger count, BOOL endsWithWildcard) {
+            NSUInteger shadowingRouteIndex = JLRShadowingNodeFindRouteIndex(rootNode, segments, count, endsWithWildcard, 0);
+            if (shadowingRouteIndex == NSNotFound) {
+                shadowed = NO;
+            } else {
+                [shadowingRouteIndexes addIndex:shadowingRouteIndex];
+            }
+        }];
+        
+        if (!checked) {
+            return;
+        }
+        
+        if (shadowed) {
+            JLRShadowedRoute *shadowedRoute = [[JLRShadowedRoute alloc] init];
+            shadowedRoute.route = route;
+            shadowedRoute.shadowingRoutes = [routes objectsAtIndexes:shadowingRouteIndexes];
+            shadowedRoute.duplicate = (shadowingRouteIndexes.count == 1 && [self _route:route matchesEveryPathOfRoute:shadowedRoute.shadowingRoutes.firstObject]);
+            [shadowedRoutes addObject:shadowedRoute];
+            
+            // the routes before it already match everything it does, so it has nothing to add to the trie
+            return;
+        }
+        
+        [route enumerateCompiledPatternsUsingBlock:^(const JLRRouteSegment *segments, NSUInteger count, BOOL endsWithWildcard) {
+            JLRShadowingNodeAddPattern(rootNode, segments, count, endsWithWildcard, routeIndex);
+        }];
+    }];
+    
+    return [shadowedRoutes copy];
+}
+
++ (BOOL)_route:(JLRRouteDefinition *)route matchesEveryPathOfRoute:(JLRRouteDefinition *)otherRoute
+{
+    JLRShadowingNode *rootNode = [[JLRShadowingNode alloc] init];
+    __block BOOL matchesEveryPath = YES;
+    
+    [route enumerateCompiledPatternsUsingBlock:^(const JLRRouteSegment *segments, NSUInteger count, BOOL endsWithWildcard) {
+        JLRShadowingNodeAddPattern(rootNode, segments, count, endsWithWildcard, 0);
+    }];
+    
+    BOOL checked = [otherRoute enumerateCompiledPatternsUsingBlock:^(const JLRRouteSegment *segments, NSUInteger count, BOOL endsWithWildcard) {
+        if (JLRShadowingNodeFindRouteIndex(rootNode, segments, count, endsWithWildcard, 0) == NSNotFound) {
+            matchesEveryPath = NO;
+        }
+    }];
+    
+    return checked && matchesEveryPath;
+}
+
+@end
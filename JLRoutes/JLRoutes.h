@@ -17,9 +17,28 @@
 #import "JLRRouteRequest.h"
 #import "JLRRouteResponse.h"
 #import "JLRParsingUtilities.h"
+#import "JLRRouteMetrics.h"
+#import "JLRRouteMatch.h"
+#import "JLRRouteRecorder.h"
+#import "JLRShadowedRoute.h"
 
 NS_ASSUME_NONNULL_BEGIN
 
+/// The error domain for errors reading and writing route table files.
+extern NSString *const JLRRouteTableErrorDomain;
+
+/// The codes of errors in JLRRouteTableErrorDomain.
+typedef NS_ENUM(NSInteger, JLRRouteTableErrorCode) {
+    /// A route is an instance of a JLRRouteDefinition subclass, which a route table can't store.
+    JLRRouteTableErrorUnsupportedRoute = 1,
+    
+    /// The file is not a route table, or it is truncated or damaged.
+    JLRRouteTableErrorCorruptFile,
+    
+    /// The file was written by a different version of JLRoutes, or for a different fingerprint.
+    JLRRouteTableErrorStaleFile
+};
+
 /// The matching route pattern, passed in the handler parameters.
 extern NSString *const JLRoutePatternKey;
 
@@ -40,6 +59,9 @@ extern NSString *const JLRoutesGlobalRoutesScheme;
 
 /**
  The JLRoutes class is the main entry-point into the JLRoutes framework. Used for accessing schemes, managing routes, and routing URLs.
+ 
+ All methods are safe to call from any thread. Routing reads an immutable snapshot of the registered routes, so it never
+ waits on other routing calls; adding or removing routes only invalidates that snapshot, and the next route attempt builds a new one.
  */
 
 @interface JLRoutes : NSObject
@@ -48,7 +70,10 @@ extern NSString *const JLRoutesGlobalRoutesScheme;
 @property (nonatomic, assign) BOOL shouldFallbackToGlobalRoutes;
 
 /// Called any time routeURL returns NO. Respects shouldFallbackToGlobalRoutes.
-@property (nonatomic, copy, nullable) void (^unmatchedURLHandler)(JLRoutes *routes, NSURL *__nullable URL, NSDictionary<NSString *, id> *__nullable parameters);
+@property (atomic, copy, nullable) void (^unmatchedURLHandler)(JLRoutes *routes, NSURL *__nullable URL, NSDictionary<NSString *, id> *__nullable parameters);
+
+/// The queue that routeURL:withParameters:completion: calls handler blocks, the unmatchedURLHandler, and its completion block on. Defaults to the main queue.
+@property (atomic, strong, null_resettable) dispatch_queue_t handlerQueue;
 
 
 ///-------------------------------
@@ -85,9 +110,29 @@ extern NSString *const JLRoutesGlobalRoutesScheme;
 /// a block returns NO, JLRoutes will continue trying to find a matching route.
 - (void)addRoute:(NSString *)routePattern priority:(NSUInteger)priority handler:(BOOL (^__nullable)(NSDictionary<NSString *, id> *parameters))handlerBlock;
 
+/// Registers a routePattern with an asynchronous handler block, which calls completion with YES if it handled the route or NO to try the next matching route.
+/// Only routeURL:withParameters:completion: calls asynchronous handler blocks. Routing synchronously skips the route and tries the next matching one.
+- (void)addRoute:(NSString *)routePattern priority:(NSUInteger)priority asyncHandler:(void (^)(NSDictionary<NSString *, id> *parameters, void (^completion)(BOOL handled)))asyncHandler;
+
 /// Registers multiple routePatterns for one handler with default priority (0) in the receiving scheme.
 - (void)addRoutes:(NSArray<NSString *> *)routePatterns handler:(BOOL (^__nullable)(NSDictionary<NSString *, id> *parameters))handlerBlock;
 
+/// Adds many route definitions at once, ordered exactly as if each had been added with addRoute: in turn, but sorted in a single pass.
+- (void)addRouteDefinitions:(NSArray <JLRRouteDefinition *> *)routeDefinitions;
+
+/// Replaces every route in the receiving scheme with routeDefinitions. URLs being routed at the same time see either the old routes or the new ones, never a mix.
+- (void)replaceAllRoutesWithRouteDefinitions:(NSArray <JLRRouteDefinition *> *)routeDefinitions;
+
+/// Writes the routes of the receiving scheme, with their patterns already compiled, to a route table file at fileURL.
+/// fingerprint should identify the set of routes (for example, a version of the configuration they come from), so a file for a different set is never loaded.
+/// Fails with JLRRouteTableErrorUnsupportedRoute if any route is an instance of a JLRRouteDefinition subclass.
+- (BOOL)writeRouteTableToURL:(NSURL *)fileURL fingerprint:(NSString *)fingerprint error:(NSError **)error;
+
+/// Replaces every route in the receiving scheme with the routes in the route table file at fileURL, without parsing any patterns.
+/// handlerProvider is called with each route's pattern and returns its handler block. Returns NO, leaving the routes unchanged,
+/// if the file is missing, damaged, or was written for a different fingerprint; register the routes normally in that case.
+- (BOOL)loadRouteTableFromURL:(NSURL *)fileURL fingerprint:(NSString *)fingerprint handlerProvider:(BOOL (^ _Nullable (^)(NSString *pattern))(NSDictionary<NSString *, id> *parameters))handlerProvider error:(NSError **)error;
+
 /// Removes the route from the receiving scheme.
 - (void)removeRoute:(JLRRouteDefinition *)routeDefinition;
 
@@ -109,6 +154,80 @@ extern NSString *const JLRoutesGlobalRoutesScheme;
 + (NSDictionary <NSString *, NSArray <JLRRouteDefinition *> *> *)allRoutes;
 
 
+///-------------------------------
+/// @name Caching Route Resolutions
+///-------------------------------
+
+
+/// The maximum number of URLs whose matching routes are remembered, so that routing a URL with the same path again skips matching. Defaults to 0, which disables the cache.
+/// Entries are keyed by the URL's path components, so URLs that only differ in their query share an entry. When a custom route definition has scheme or host match constraints, the scheme and host are part of the key too. Adding or removing routes or changing global options empties the cache. Setting this resets the hit and miss counts.
+@property (nonatomic, assign) NSUInteger resolutionCacheLimit;
+
+/// The number of routing attempts that found their matching routes in the resolution cache.
+@property (nonatomic, assign, readonly) NSUInteger resolutionCacheHitCount;
+
+/// The number of routing attempts that had to match routes because the resolution cache did not have them.
+/// URLs that the prefilter turns away before the cache is consulted, because no route could match their path components, aren't counted.
+@property (nonatomic, assign, readonly) NSUInteger resolutionCacheMissCount;
+
+
+///-------------------------------
+/// @name Estimating Memory Usage
+///-------------------------------
+
+
+/// An estimate, in bytes, of the memory used by the receiving scheme's routes and their compiled patterns. Pattern path components and variable names are
+/// interned into a pool shared by all of a scheme's routes, so strings repeated across routes (like the 'user' of '/user/:userID/…') are only counted once.
+@property (nonatomic, assign, readonly) NSUInteger estimatedMemoryUsage;
+
+/// estimatedMemoryUsage divided by the number of routes, or 0 if there are no routes.
+@property (nonatomic, assign, readonly) NSUInteger estimatedMemoryUsagePerRoute;
+
+
+///-------------------------------
+/// @name Finding Shadowed Routes
+///-------------------------------
+
+
+/// Returns the routes in the receiving scheme that are never the first match for a URL, because routes tried before them match every URL they do
+/// (including routes registered more than once). They are only reached when the handler blocks of those earlier routes return NO.
+- (NSArray <JLRShadowedRoute *> *)shadowedRoutes;
+
+/// Configures if the routes returned by shadowedRoutes are left out of matching, so that URLs aren't checked against them. Defaults to NO.
+/// Pruned routes are still returned by routes, but are no longer tried after the handler block of a route shadowing them returns NO, so only
+/// enable this if those handler blocks always return YES.
+@property (nonatomic, assign) BOOL prunesShadowedRoutes;
+
+
+///-------------------------------
+/// @name Ordering Routes by Use
+///-------------------------------
+
+
+/// Configures if the receiving scheme counts how often each route handles a URL, and periodically moves the most used routes ahead of the other routes with the same priority. Defaults to NO.
+/// A route is only moved past routes that can't match any of the same URLs, so every URL still matches the same routes in the same order; only routes returns them in a different order.
+@property (atomic, assign) BOOL adaptiveOrderingEnabled;
+
+/// Returns the patterns of the routes that adaptive ordering has counted handling URLs, most used first, to be passed to applyRouteOrdering: on a later launch.
+- (NSArray <NSString *> *)learnedRouteOrdering;
+
+/// Moves the routes with routePatterns ahead of the other routes with the same priority, as far as they can be without changing which routes any URL matches.
+/// Earlier patterns end up ahead of later ones where they can't pass each other, and patterns without any registered routes are ignored.
+- (void)applyRouteOrdering:(NSArray <NSString *> *)routePatterns;
+
+
+///-------------------------------
+/// @name Inspecting Metrics
+///-------------------------------
+
+
+/// Returns a snapshot of the metrics recorded for the receiving scheme and its routes. Metrics are only recorded while +isMetricsEnabled is YES.
+- (JLRRouteMetrics *)metricsSnapshot;
+
+/// Sets all of the metrics recorded for the receiving scheme and its routes back to zero.
+- (void)resetMetrics;
+
+
 ///-------------------------------
 /// @name Routing URLs
 ///-------------------------------
@@ -136,6 +255,68 @@ extern NSString *const JLRoutesGlobalRoutesScheme;
 /// Additional parameters get passed through to the matched route block.
 - (BOOL)routeURL:(nullable NSURL *)URL withParameters:(nullable NSDictionary<NSString *, id> *)parameters;
 
+
+///-------------------------------
+/// @name Routing URLs Asynchronously
+///-------------------------------
+
+
+/// Routes a URL in any routes scheme, as -routeURL:withParameters:completion: does in the scheme of URL.
++ (void)routeURL:(nullable NSURL *)URL withParameters:(nullable NSDictionary<NSString *, id> *)parameters completion:(nullable void (^)(BOOL didRoute))completion;
+
+/// Routes a URL in a specific scheme without blocking the calling thread. The URL is matched in the background, then handler blocks
+/// are called on handlerQueue until one handles it. An asynchronous handler block is waited for before moving on to the next route.
+/// Routing another URL asynchronously in the same scheme cancels this one: no more handler blocks are called, and unless a handler block already
+/// handled the URL, completion is called with NO.
+- (void)routeURL:(nullable NSURL *)URL withParameters:(nullable NSDictionary<NSString *, id> *)parameters completion:(nullable void (^)(BOOL didRoute))completion;
+
+
+///-------------------------------
+/// @name Matching URLs Ahead of Routing
+///-------------------------------
+
+
+/// Matches URL against the routes of its scheme (falling back to the global routes), without calling any handler blocks.
+/// The returned match can be checked with canRoute and later routed with +routeMatch:, without parsing or matching URL again.
++ (nullable JLRRouteMatch *)matchURL:(nullable NSURL *)URL;
+
+/// Matches URL against the routes of its scheme as +matchURL: does, with additional parameters to pass to the matched route block.
++ (nullable JLRRouteMatch *)matchURL:(nullable NSURL *)URL withParameters:(nullable NSDictionary<NSString *, id> *)parameters;
+
+/// Matches URL against the routes of the receiving scheme, without calling any handler blocks.
+- (nullable JLRRouteMatch *)matchURL:(nullable NSURL *)URL;
+
+/// Matches URL against the routes of the receiving scheme, with additional parameters to pass to the matched route block.
+- (nullable JLRRouteMatch *)matchURL:(nullable NSURL *)URL withParameters:(nullable NSDictionary<NSString *, id> *)parameters;
+
+/// Routes a match made by matchURL:, calling the handler blocks of its routes in order until one returns YES.
+/// Falls back to the global routes and the unmatchedURLHandler just as routeURL: does.
++ (BOOL)routeMatch:(nullable JLRRouteMatch *)match;
+
+
+///-------------------------------
+/// @name Routing Batches of URLs
+///-------------------------------
+
+
+/// Returns, for each of URLs and in the same order, @YES if it will successfully match against any registered route and @NO if not.
+/// The URLs are matched concurrently.
++ (NSArray <NSNumber *> *)canRouteURLs:(NSArray <NSURL *> *)URLs;
+
+/// Returns, for each of URLs and in the same order, @YES if it will successfully match against any registered route for the current scheme and @NO if not.
+/// The URLs are matched concurrently.
+- (NSArray <NSNumber *> *)canRouteURLs:(NSArray <NSURL *> *)URLs;
+
+/// Routes each of URLs in any routes scheme, as if by +routeURL:withParameters:, and returns whether each one was routed in the same order.
+/// The URLs are parsed and matched concurrently, before any handler is called. Handler blocks (and the unmatchedURLHandler) are then
+/// called on the calling thread, in the order of URLs.
++ (NSArray <NSNumber *> *)routeURLs:(NSArray <NSURL *> *)URLs withParameters:(nullable NSDictionary<NSString *, id> *)parameters;
+
+/// Routes each of URLs in a specific scheme, as if by -routeURL:withParameters:, and returns whether each one was routed in the same order.
+/// The URLs are parsed and matched concurrently, before any handler is called. Handler blocks (and the unmatchedURLHandler) are then
+/// called on the calling thread, in the order of URLs.
+- (NSArray <NSNumber *> *)routeURLs:(NSArray <NSURL *> *)URLs withParameters:(nullable NSDictionary<NSString *, id> *)parameters;
+
 @end
 
 
@@ -153,6 +334,26 @@ extern NSString *const JLRoutesGlobalRoutesScheme;
 /// Returns current verbose logging enabled state. Defaults to NO.
 + (BOOL)isVerboseLoggingEnabled;
 
+/// Configures an object to receive an event for each step taken while routing. When set, it receives the events instead of verbose logging. Defaults to nil.
+/// Can be changed from any thread, even while URLs are being routed. Routing that is already under way may still send a few events to the previous sink.
++ (void)setTraceSink:(nullable id <JLRRouteTraceSink>)traceSink;
+
+/// Returns the object receiving routing events. Defaults to nil.
++ (nullable id <JLRRouteTraceSink>)traceSink;
+
+/// Configures if match counts, handler durations and match latencies are recorded for each scheme and route. Defaults to NO.
++ (void)setMetricsEnabled:(BOOL)metricsEnabled;
+
+/// Returns if match counts, handler durations and match latencies are recorded for each scheme and route. Defaults to NO.
++ (BOOL)isMetricsEnabled;
+
+/// Configures a recorder to append a record of each URL routed with -routeURL:, -routeURL:withParameters: or -routeURLs:withParameters: (and their class method variants). Defaults to nil.
+/// Can be changed from any thread, even while URLs are being routed.
++ (void)setRouteRecorder:(nullable JLRRouteRecorder *)routeRecorder;
+
+/// Returns the recorder appending a record of each routed URL. Defaults to nil.
++ (nullable JLRRouteRecorder *)routeRecorder;
+
 /// Configures if '+' should be replaced with spaces in parsed values. Defaults to YES.
 + (void)setShouldDecodePlusSymbols:(BOOL)shouldDecode;
 
@@ -13,6 +13,20 @@
 #import "JLRoutes.h"
 #import "JLRRouteDefinition.h"
 #import "JLRParsingUtilities.h"
+#import "JLRRouteIndex.h"
+#import "JLRResolutionCache.h"
+#import "JLRRouteTable.h"
+#import "JLRRouteMatch.h"
+#import "JLRRouteStringPool.h"
+#import "JLRRouteRecorder.h"
+#import "JLRShadowedRoute.h"
+#import "JLRRouteOrdering.h"
+#import <stdatomic.h>
+#if defined(__APPLE__)
+#import <mach/mach_time.h>
+#else
+#import <time.h>
+#endif
 
 
 NSString *const JLRoutePatternKey = @"JLRoutePattern";
@@ -21,8 +35,109 @@ NSString *const JLRouteSchemeKey = @"JLRouteScheme";
 NSString *const JLRouteWildcardComponentsKey = @"JLRouteWildcardComponents";
 NSString *const JLRoutesGlobalRoutesScheme = @"JLRoutesGlobalRoutesScheme";
 
+// with adaptive ordering enabled, a scheme's routes are reordered each time this many URLs have been handled, moving at most this many of the most used routes
+static const uint64_t JLRAdaptiveOrderingHitInterval = 1024;
+static const NSUInteger JLRAdaptiveOrderingMaximumMovedRouteCount = 64;
 
-static NSMutableDictionary *JLRGlobal_routeControllersMap = nil;
+
+// Holds the immutable scheme -> JLRoutes map. Readers load the current map without locking, writers publish a new one.
+@interface JLRRouteControllersRegistry : NSObject
+
+@property (atomic, copy) NSDictionary <NSString *, JLRoutes *> *routeControllersMap;
+
+@end
+
+
+@implementation JLRRouteControllersRegistry
+
+@end
+
+
+static JLRRouteControllersRegistry *JLRGlobal_routeControllersRegistry = nil;
+
+
+// Holds the objects routing reports to. They're changed while synchronized on the holder, and read without locking by routing on any thread.
+@interface JLRRouteObservers : NSObject
+
+@property (atomic, strong, nullable) id <JLRRouteTraceSink> traceSink;
+
+// the sink events are actually sent to: traceSink, the log sink if verbose logging is enabled, or nil
+@property (atomic, strong, nullable) id <JLRRouteTraceSink> activeTraceSink;
+
+@property (atomic, strong, nullable) JLRRouteRecorder *routeRecorder;
+
+@end
+
+
+@implementation JLRRouteObservers
+
+@end
+
+
+static JLRRouteObservers *JLRGlobal_routeObservers = nil;
+
+
+// Logs trace events in the format used by verbose logging.
+@interface JLRRouteLogTraceSink : NSObject <JLRRouteTraceSink>
+
+@end
+
+
+@implementation JLRRouteLogTraceSink
+
+- (void)routes:(JLRoutes *)routes traceEvent:(JLRRouteTraceEvent)event URL:(NSURL *)URL route:(JLRRouteDefinition *)route parameters:(NSDictionary *)parameters
+{
+    switch (event) {
+        case JLRRouteTraceEventWillRouteURL:
+            NSLog(@"[JLRoutes]: Trying to route URL %@", URL);
+            break;
+        case JLRRouteTraceEventDidMatchRoute:
+            NSLog(@"[JLRoutes]: Successfully matched %@", route);
+            NSLog(@"[JLRoutes]: Match parameters are %@", parameters);
+            break;
+        case JLRRouteTraceEventHandlerDidDecline:
+            NSLog(@"[JLRoutes]: Handler declined %@", route);
+            break;
+        case JLRRouteTraceEventDidNotRouteURL:
+            NSLog(@"[JLRoutes]: Could not find a matching route");
+            break;
+        case JLRRouteTraceEventWillFallBackToGlobalRoutes:
+            NSLog(@"[JLRoutes]: Falling back to global routes...");
+            break;
+        case JLRRouteTraceEventWillCallUnmatchedURLHandler:
+            NSLog(@"[JLRoutes]: Falling back to the unmatched URL handler");
+            break;
+    }
+}
+
+@end
+
+
+// Collects what routing one URL came to, across the global routes fallback, for the route recorder.
+@interface JLRRouteOutcome : NSObject
+
+@property (nonatomic, strong, nullable) JLRRouteDefinition *route;
+@property (nonatomic, assign) NSUInteger declinedHandlerCount;
+
+@end
+
+
+@implementation JLRRouteOutcome
+
+@end
+
+
+// Shared by every step of routing one URL asynchronously, so that routing a newer URL can stop it between steps.
+@interface JLRAsyncRouteToken : NSObject
+
+@property (atomic, assign, getter=isCancelled) BOOL cancelled;
+
+@end
+
+
+@implementation JLRAsyncRouteToken
+
+@end
 
 
 // global options (configured in +initialize)
@@ -30,14 +145,167 @@ static BOOL JLRGlobal_verboseLoggingEnabled;
 static BOOL JLRGlobal_shouldDecodePlusSymbols;
 static BOOL JLRGlobal_alwaysTreatsHostAsPathComponent;
 static Class JLRGlobal_routeDefinitionClass;
+static BOOL JLRGlobal_metricsEnabled;
+static JLRRouteLogTraceSink *JLRGlobal_logTraceSink;
+
+
+// must be called while synchronized on JLRGlobal_routeObservers
+static void JLRUpdateActiveTraceSink(void)
+{
+    JLRGlobal_routeObservers.activeTraceSink = JLRGlobal_routeObservers.traceSink ?: (JLRGlobal_verboseLoggingEnabled ? JLRGlobal_logTraceSink : nil);
+}
+
+
+// Sends a trace event. Without a trace sink this is a single check, so it is cheap enough to call while routing.
+static inline void JLRTrace(JLRoutes *routes, JLRRouteTraceEvent event, NSURL *URL, JLRRouteDefinition *route, NSDictionary *parameters)
+{
+    id <JLRRouteTraceSink> traceSink = JLRGlobal_routeObservers.activeTraceSink;
+    if (traceSink != nil) {
+        [traceSink routes:routes traceEvent:event URL:URL route:route parameters:parameters];
+    }
+}
+
+
+// A monotonic timestamp in nanoseconds, for measuring durations.
+static uint64_t JLRMonotonicNanoseconds(void)
+{
+#if defined(__APPLE__)
+    static mach_timebase_info_data_t timebaseInfo;
+    if (timebaseInfo.denom == 0) {
+        mach_timebase_info(&timebaseInfo);
+    }
+    return mach_absolute_time() * timebaseInfo.numer / timebaseInfo.denom;
+#else
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (uint64_t)time.tv_sec * NSEC_PER_SEC + (uint64_t)time.tv_nsec;
+#endif
+}
+
+
+// Steps through the routes that match a request, in order. Finding a match is separate from acting on it, so that
+// matching can happen ahead of time (and on another thread), and resume with the next route if a handler declines.
+@interface JLRRouteMatchCursor : NSObject
+
+@property (nonatomic, strong, readonly) JLRRouteRequest *request;
+@property (nonatomic, strong, readonly, nullable) JLRRouteDefinition *route;
+@property (nonatomic, strong, readonly, nullable) JLRRouteResponse *response;
+@property (nonatomic, strong, readonly, nullable) JLRRouteMatch *match;
+
+- (instancetype)initWithRequest:(JLRRouteRequest *)request candidateRoutes:(NSArray <JLRRouteDefinition *> *)candidateRoutes routeVariables:(nullable NSArray *)routeVariables;
+
+// Steps through the routes of a match that was already made, without checking them again.
+- (instancetype)initWithMatch:(JLRRouteMatch *)match;
+
+// Returns YES if there is a current match, finding the next one if needed.
+- (BOOL)findMatch;
+
+// Moves past the current match.
+- (void)skipMatch;
+
+@end
+
+
+@interface JLRRouteMatchCursor ()
+
+@property (nonatomic, strong, nullable) JLRRouteDefinition *route;
+@property (nonatomic, strong, nullable) JLRRouteResponse *response;
+
+@end
+
+
+@implementation JLRRouteMatchCursor
+{
+    NSArray <JLRRouteDefinition *> *_candidateRoutes;
+    NSArray *_routeVariables;
+    NSArray <NSDictionary *> *_parameters;
+    NSUInteger _index;
+}
+
+- (instancetype)initWithRequest:(JLRRouteRequest *)request candidateRoutes:(NSArray <JLRRouteDefinition *> *)candidateRoutes routeVariables:(nullable NSArray *)routeVariables
+{
+    if ((self = [super init])) {
+        _request = request;
+        _candidateRoutes = candidateRoutes;
+        _routeVariables = routeVariables;
+    }
+    return self;
+}
+
+- (instancetype)initWithMatch:(JLRRouteMatch *)match
+{
+    if ((self = [super init])) {
+        _request = match.request;
+        _candidateRoutes = match.routes;
+        _parameters = match.parameters;
+        _match = match;
+    }
+    return self;
+}
+
+- (BOOL)findMatch
+{
+    if (self.response != nil) {
+        return YES;
+    }
+    
+    for (; _index < _candidateRoutes.count; _index++) {
+        JLRRouteDefinition *route = _candidateRoutes[_index];
+        id routeVariables = _routeVariables[_index];
+        JLRRouteResponse *response = nil;
+        
+        if (_parameters != nil) {
+            // every route of a match is known to match, with its parameters already built
+            self.route = route;
+            self.response = [JLRRouteResponse validMatchResponseWithParameters:_parameters[_index]];
+            return YES;
+        } else if ([routeVariables isKindOfClass:[NSDictionary class]]) {
+            // already known to match, only the match parameters are specific to this request
+            response = [JLRRouteResponse validMatchResponseWithParameters:[route matchParametersForRequest:self.request routeVariables:routeVariables]];
+        } else {
+            // check each route for a matching response
+            response = [route routeResponseForRequest:self.request];
+        }
+        
+        if (JLRGlobal_metricsEnabled) {
+            [route recordMatchAttempt:response.isMatch];
+        }
+        
+        if (response.isMatch) {
+            self.route = route;
+            self.response = response;
+            return YES;
+        }
+    }
+    
+    return NO;
+}
+
+- (void)skipMatch
+{
+    self.route = nil;
+    self.response = nil;
+    _index++;
+}
+
+@end
 
 
 @interface JLRoutes ()
 
 @property (nonatomic, strong) NSMutableArray *mutableRoutes;
+@property (nonatomic, strong) NSMutableDictionary <NSString *, NSMutableArray <JLRRouteDefinition *> *> *routesByPattern;
+@property (nonatomic, strong) NSHashTable <JLRRouteDefinition *> *removedRoutes;
+@property (nonatomic, strong) JLRRouteStringPool *stringPool;
+@property (nonatomic, strong, nullable) JLRAsyncRouteToken *pendingAsyncRouteToken;
+@property (atomic, strong, nullable) JLRRouteIndex *routeIndex;
+@property (atomic, strong, nullable) JLRResolutionCache *resolutionCache;
+@property (nonatomic, strong, nullable) NSArray <JLRShadowedRoute *> *shadowedRouteAnalysis;
 @property (nonatomic, strong) NSString *scheme;
 
 - (JLRRouteRequestOptions)_routeRequestOptions;
++ (void)_removeAllResolutionsForAllSchemes;
+- (void)_recordMatchLatency:(uint64_t)nanoseconds;
 
 @end
 
@@ -45,306 +313,1173 @@ static Class JLRGlobal_routeDefinitionClass;
 #pragma mark -
 
 @implementation JLRoutes
+{
+    // metrics, updated concurrently by every thread routing through this scheme
+    _Atomic(uint64_t) _routingCount;
+    _Atomic(uint64_t) _missCount;
+    _Atomic(uint64_t) _globalFallbackCount;
+    _Atomic(uint64_t) _unmatchedURLHandlerCount;
+    _Atomic(uint64_t) _matchLatencyBuckets[JLRRouteMatchLatencyBucketCount];
+    
+    // URLs handled since adaptive ordering was enabled
+    _Atomic(uint64_t) _orderingHitCount;
+}
+
++ (void)initialize
+{
+    if (self == [JLRoutes class]) {
+        // Set default global options
+        JLRGlobal_verboseLoggingEnabled = NO;
+        JLRGlobal_shouldDecodePlusSymbols = YES;
+        JLRGlobal_alwaysTreatsHostAsPathComponent = NO;
+        JLRGlobal_routeDefinitionClass = [JLRRouteDefinition class];
+        JLRGlobal_metricsEnabled = NO;
+        JLRGlobal_logTraceSink = [[JLRRouteLogTraceSink alloc] init];
+        JLRGlobal_routeObservers = [[JLRRouteObservers alloc] init];
+        
+        JLRGlobal_routeControllersRegistry = [[JLRRouteControllersRegistry alloc] init];
+        JLRGlobal_routeControllersRegistry.routeControllersMap = @{};
+    }
+}
+
+- (instancetype)init
+{
+    if ((self = [super init])) {
+        self.mutableRoutes = [NSMutableArray array];
+        self.routesByPattern = [NSMutableDictionary dictionary];
+        self.removedRoutes = [NSHashTable hashTableWithOptions:NSPointerFunctionsObjectPointerPersonality];
+        self.stringPool = [[JLRRouteStringPool alloc] init];
+        _handlerQueue = dispatch_get_main_queue();
+    }
+    return self;
+}
+
+- (NSString *)description
+{
+    return [[self routes] description];
+}
+
++ (NSDictionary <NSString *, NSArray <JLRRouteDefinition *> *> *)allRoutes;
+{
+    NSMutableDictionary *dictionary = [NSMutableDictionary dictionary];
+    NSDictionary <NSString *, JLRoutes *> *routeControllersMap = JLRGlobal_routeControllersRegistry.routeControllersMap;
+    
+    for (NSString *namespace in routeControllersMap) {
+        JLRoutes *routesController = routeControllersMap[namespace];
+        dictionary[namespace] = [routesController routes];
+    }
+    
+    return [dictionary copy];
+}
+
+
+#pragma mark - Routing Schemes
+
++ (instancetype)globalRoutes
+{
+    return [self routesForScheme:JLRoutesGlobalRoutesScheme];
+}
+
++ (instancetype)routesForScheme:(NSString *)scheme
+{
+    JLRoutes *routesController = JLRGlobal_routeControllersRegistry.routeControllersMap[scheme];
+    
+    if (routesController != nil) {
+        return routesController;
+    }
+    
+    @synchronized (JLRGlobal_routeControllersRegistry) {
+        // check again, another thread may have created it while we were waiting
+        NSDictionary <NSString *, JLRoutes *> *routeControllersMap = JLRGlobal_routeControllersRegistry.routeControllersMap;
+        routesController = routeControllersMap[scheme];
+        
+        if (routesController == nil) {
+            routesController = [[self alloc] init];
+            routesController.scheme = scheme;
+            
+            NSMutableDictionary *updatedRouteControllersMap = [routeControllersMap mutableCopy];
+            updatedRouteControllersMap[scheme] = routesController;
+            JLRGlobal_routeControllersRegistry.routeControllersMap = updatedRouteControllersMap;
+        }
+    }
+    
+    return routesController;
+}
+
++ (void)unregisterRouteScheme:(NSString *)scheme
+{
+    @synchronized (JLRGlobal_routeControllersRegistry) {
+        NSMutableDictionary *updatedRouteControllersMap = [JLRGlobal_routeControllersRegistry.routeControllersMap mutableCopy];
+        [updatedRouteControllersMap removeObjectForKey:scheme];
+        JLRGlobal_routeControllersRegistry.routeControllersMap = updatedRouteControllersMap;
+    }
+}
+
++ (void)unregisterAllRouteSchemes
+{
+    @synchronized (JLRGlobal_routeControllersRegistry) {
+        JLRGlobal_routeControllersRegistry.routeControllersMap = @{};
+    }
+}
+
+
+#pragma mark - Registering Routes
+
+- (void)addRoute:(JLRRouteDefinition *)routeDefinition
+{
+    [self _registerRoute:routeDefinition];
+}
+
+- (void)addRoute:(NSString *)routePattern handler:(BOOL (^)(NSDictionary<NSString *, id> *parameters))handlerBlock
+{
+    [self addRoute:routePattern priority:0 handler:handlerBlock];
+}
+
+- (void)addRoute:(NSString *)routePattern priority:(NSUInteger)priority asyncHandler:(void (^)(NSDictionary<NSString *, id> *parameters, void (^completion)(BOOL handled)))asyncHandler
+{
+    JLRRouteDefinition *route = [[JLRGlobal_routeDefinitionClass alloc] initWithPattern:routePattern priority:priority asyncHandlerBlock:asyncHandler];
+    [self _registerRoute:route];
+}
+
+- (void)addRoutes:(NSArray<NSString *> *)routePatterns handler:(BOOL (^)(NSDictionary<NSString *, id> *parameters))handlerBlock
+{
+    NSMutableArray <JLRRouteDefinition *> *routes = [NSMutableArray arrayWithCapacity:routePatterns.count];
+    
+    for (NSString *routePattern in routePatterns) {
+        [routes addObject:[[JLRGlobal_routeDefinitionClass alloc] initWithPattern:routePattern priority:0 handlerBlock:handlerBlock]];
+    }
+    
+    [self addRouteDefinitions:routes];
+}
+
+- (void)addRouteDefinitions:(NSArray <JLRRouteDefinition *> *)routeDefinitions
+{
+    [self _registerRoutes:routeDefinitions replacingExistingRoutes:NO];
+}
+
+- (void)replaceAllRoutesWithRouteDefinitions:(NSArray <JLRRouteDefinition *> *)routeDefinitions
+{
+    [self _registerRoutes:routeDefinitions replacingExistingRoutes:YES];
+}
+
+- (void)addRoute:(NSString *)routePattern priority:(NSUInteger)priority handler:(BOOL (^)(NSDictionary<NSString *, id> *parameters))handlerBlock
+{
+    // optional params are matched by the definition itself, so one definition covers every combination of them
+    JLRRouteDefinition *route = [[JLRGlobal_routeDefinitionClass alloc] initWithPattern:routePattern priority:priority handlerBlock:handlerBlock];
+    [self _registerRoute:route];
+}
+
+- (BOOL)writeRouteTableToURL:(NSURL *)fileURL fingerprint:(NSString *)fingerprint error:(NSError **)error
+{
+    NSData *data = [JLRRouteTable dataWithRoutes:[self routes] fingerprint:fingerprint error:error];
+    
+    if (data == nil) {
+        return NO;
+    }
+    
+    return [data writeToURL:fileURL options:NSDataWritingAtomic error:error];
+}
+
+- (BOOL)loadRouteTableFromURL:(NSURL *)fileURL fingerprint:(NSString *)fingerprint handlerProvider:(BOOL (^ _Nullable (^)(NSString *pattern))(NSDictionary<NSString *, id> *parameters))handlerProvider error:(NSError **)error
+{
+    NSArray <JLRRouteDefinition *> *routes = [JLRRouteTable routesWithContentsOfURL:fileURL fingerprint:fingerprint handlerProvider:handlerProvider error:error];
+    
+    if (routes == nil) {
+        return NO;
+    }
+    
+    // route tables are written in routing order, so there's nothing to sort
+    [self _registerSortedRoutes:routes replacingExistingRoutes:YES];
+    return YES;
+}
+
+- (void)removeRoute:(JLRRouteDefinition *)routeDefinition
+{
+    @synchronized (self) {
+        NSMutableArray <JLRRouteDefinition *> *routes = self.routesByPattern[routeDefinition.pattern];
+        NSIndexSet *indexes = [routes indexesOfObjectsPassingTest:^BOOL(JLRRouteDefinition *route, NSUInteger index, BOOL *stop) {
+            return [route isEqual:routeDefinition];
+        }];
+        
+        if (indexes.count > 0) {
+            [self _removeRoutesAtIndexes:indexes withPattern:routeDefinition.pattern];
+        }
+    }
+}
+
+- (void)removeRouteWithPattern:(NSString *)routePattern
+{
+    @synchronized (self) {
+        NSMutableArray <JLRRouteDefinition *> *routes = self.routesByPattern[routePattern];
+        
+        if (routes.count == 0) {
+            return;
+        }
+        
+        // the first of these in the route table is the earliest added of the ones with the highest priority
+        NSUInteger firstIndex = 0;
+        for (NSUInteger index = 1; index < routes.count; index++) {
+            if (routes[index].priority > routes[firstIndex].priority) {
+                firstIndex = index;
+            }
+        }
+        
+        [self _removeRoutesAtIndexes:[NSIndexSet indexSetWithIndex:firstIndex] withPattern:routePattern];
+    }
+}
+
+- (void)removeAllRoutes
+{
+    @synchronized (self) {
+        [self.mutableRoutes removeAllObjects];
+        [self.routesByPattern removeAllObjects];
+        [self.removedRoutes removeAllObjects];
+        self.stringPool = [[JLRRouteStringPool alloc] init];
+        [self _invalidateRouteIndex];
+    }
+}
+
+- (void)setObject:(id)handlerBlock forKeyedSubscript:(NSString *)routePatten
+{
+    [self addRoute:routePatten handler:handlerBlock];
+}
+
+- (NSArray <JLRRouteDefinition *> *)routes;
+{
+    return [self _currentRouteIndex].routes;
+}
+
+#pragma mark - Finding Shadowed Routes
+
+@synthesize prunesShadowedRoutes = _prunesShadowedRoutes;
+
+- (void)setPrunesShadowedRoutes:(BOOL)prunesShadowedRoutes
+{
+    @synchronized (self) {
+        _prunesShadowedRoutes = prunesShadowedRoutes;
+        [self _invalidateRouteIndex];
+    }
+}
+
+- (BOOL)prunesShadowedRoutes
+{
+    @synchronized (self) {
+        return _prunesShadowedRoutes;
+    }
+}
+
+- (NSArray <JLRShadowedRoute *> *)shadowedRoutes
+{
+    @synchronized (self) {
+        // the analysis is kept until the routes change, just like the route index it is made from
+        JLRRouteIndex *routeIndex = [self _currentRouteIndex];
+        if (self.shadowedRouteAnalysis == nil) {
+            self.shadowedRouteAnalysis = [JLRShadowedRoute shadowedRoutesInRoutes:routeIndex.routes];
+        }
+        return self.shadowedRouteAnalysis;
+    }
+}
+
+#pragma mark - Ordering Routes by Use
+
+- (NSArray <NSString *> *)learnedRouteOrdering
+{
+    NSArray <JLRRouteDefinition *> *usedRoutes = [self _usedRoutesInRoutes:[self routes]];
+    NSMutableOrderedSet <NSString *> *routePatterns = [NSMutableOrderedSet orderedSetWithCapacity:usedRoutes.count];
+    
+    for (JLRRouteDefinition *route in usedRoutes) {
+        [routePatterns addObject:route.pattern];
+    }
+    
+    return [routePatterns array];
+}
+
+- (void)applyRouteOrdering:(NSArray <NSString *> *)routePatterns
+{
+    @synchronized (self) {
+        [self _compactRoutes];
+        
+        NSMutableArray <JLRRouteDefinition *> *routesToMove = [NSMutableArray arrayWithCapacity:routePatterns.count];
+        for (NSString *routePattern in routePatterns) {
+            [routesToMove addObjectsFromArray:self.routesByPattern[routePattern] ?: @[]];
+        }
+        
+        [self _moveRoutesForward:routesToMove];
+    }
+}
+
+- (void)_recordOrderingHitForRoute:(JLRRouteDefinition *)route
+{
+    [route recordOrderingHit];
+    
+    if ((atomic_fetch_add_explicit(&_orderingHitCount, 1, memory_order_relaxed) + 1) % JLRAdaptiveOrderingHitInterval == 0) {
+        // reordering compares patterns, so it happens off the routing thread; an unregistered scheme isn't kept alive for it
+        __weak typeof(self) weakSelf = self;
+        dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_BACKGROUND, 0), ^{
+            [weakSelf _reorderRoutesByUse];
+        });
+    }
+}
+
+- (void)_reorderRoutesByUse
+{
+    @synchronized (self) {
+        [self _compactRoutes];
+        
+        NSMutableArray <JLRRouteDefinition *> *usedRoutes = [self _usedRoutesInRoutes:self.mutableRoutes];
+        
+        if (usedRoutes.count > JLRAdaptiveOrderingMaximumMovedRouteCount) {
+            [usedRoutes removeObjectsInRange:NSMakeRange(JLRAdaptiveOrderingMaximumMovedRouteCount, usedRoutes.count - JLRAdaptiveOrderingMaximumMovedRouteCount)];
+        }
+        
+        [self _moveRoutesForward:usedRoutes];
+        
+        // older hits count for less each time, so the order follows changes in how the routes are used
+        for (JLRRouteDefinition *route in usedRoutes) {
+            [route decayOrderingHitCount];
+        }
+    }
+}
+
+- (NSMutableArray <JLRRouteDefinition *> *)_usedRoutesInRoutes:(NSArray <JLRRouteDefinition *> *)routes
+{
+    // the routes that have handled URLs, most used first and otherwise in the order they are tried. The counts keep changing
+    // while URLs are routed, so they are read once up front to sort by.
+    NSMutableArray <JLRRouteDefinition *> *usedRoutes = [NSMutableArray array];
+    NSMapTable <JLRRouteDefinition *, NSNumber *> *hitCounts = [NSMapTable mapTableWithKeyOptions:NSPointerFunctionsObjectPointerPersonality valueOptions:NSPointerFunctionsStrongMemory];
+    
+    for (JLRRouteDefinition *route in routes) {
+        NSUInteger hitCount = route.orderingHitCount;
+        if (hitCount > 0) {
+            [usedRoutes addObject:route];
+            [hitCounts setObject:@(hitCount) forKey:route];
+        }
+    }
+    
+    [usedRoutes sortWithOptions:NSSortStable usingComparator:^NSComparisonResult(JLRRouteDefinition *route1, JLRRouteDefinition *route2) {
+        return [[hitCounts objectForKey:route2] compare:[hitCounts objectForKey:route1]];
+    }];
+    
+    return usedRoutes;
+}
+
+- (void)_moveRoutesForward:(NSArray <JLRRouteDefinition *> *)routesToMove
+{
+    // must be called while synchronized on self, after compacting the routes
+    NSArray <JLRRouteDefinition *> *routes = [JLRRouteOrdering routes:self.mutableRoutes byMovingRoutesForward:routesToMove];
+    
+    if (![routes isEqualToArray:self.mutableRoutes]) {
+        self.mutableRoutes = [routes mutableCopy];
+        [self _invalidateRouteIndex];
+    }
+}
+
+#pragma mark - Caching Route Resolutions
+
+- (void)setResolutionCacheLimit:(NSUInteger)resolutionCacheLimit
+{
+    @synchronized (self) {
+        _resolutionCacheLimit = resolutionCacheLimit;
+        self.resolutionCache = resolutionCacheLimit > 0 ? [[JLRResolutionCache alloc] initWithLimit:resolutionCacheLimit] : nil;
+    }
+}
+
+- (NSUInteger)resolutionCacheHitCount
+{
+    return self.resolutionCache.hitCount;
+}
+
+- (NSUInteger)resolutionCacheMissCount
+{
+    return self.resolutionCache.missCount;
+}
+
+
+#pragma mark - Estimating Memory Usage
+
+- (NSUInteger)estimatedMemoryUsage
+{
+    @synchronized (self) {
+        JLRRouteStringPool *stringPool = self.stringPool;
+        NSUInteger usage = stringPool.estimatedMemoryUsage;
+        
+        for (JLRRouteDefinition *route in self.mutableRoutes) {
+            if (![self.removedRoutes containsObject:route]) {
+                usage += [route estimatedMemoryUsageExcludingStringsInPool:stringPool];
+            }
+        }
+        
+        return usage;
+    }
+}
+
+- (NSUInteger)estimatedMemoryUsagePerRoute
+{
+    @synchronized (self) {
+        NSUInteger routeCount = self.mutableRoutes.count - self.removedRoutes.count;
+        return routeCount > 0 ? self.estimatedMemoryUsage / routeCount : 0;
+    }
+}
+
+
+#pragma mark - Inspecting Metrics
+
+- (JLRRouteMetrics *)metricsSnapshot
+{
+    NSMutableArray <NSNumber *> *matchLatencyHistogram = [NSMutableArray arrayWithCapacity:JLRRouteMatchLatencyBucketCount];
+    for (NSUInteger index = 0; index < JLRRouteMatchLatencyBucketCount; index++) {
+        [matchLatencyHistogram addObject:@(atomic_load_explicit(&_matchLatencyBuckets[index], memory_order_relaxed))];
+    }
+    
+    NSMutableArray <JLRRouteDefinitionMetrics *> *routeMetrics = [NSMutableArray array];
+    for (JLRRouteDefinition *route in [self routes]) {
+        [routeMetrics addObject:[route metricsSnapshot]];
+    }
+    
+    NSUInteger routingCount = (NSUInteger)atomic_load_explicit(&_routingCount, memory_order_relaxed);
+    NSUInteger missCount = (NSUInteger)atomic_load_explicit(&_missCount, memory_order_relaxed);
+    NSUInteger globalFallbackCount = (NSUInteger)atomic_load_explicit(&_globalFallbackCount, memory_order_relaxed);
+    NSUInteger unmatchedURLHandlerCount = (NSUInteger)atomic_load_explicit(&_unmatchedURLHandlerCount, memory_order_relaxed);
+    
+    return [[JLRRouteMetrics alloc] initWithScheme:self.scheme routingCount:routingCount missCount:missCount globalFallbackCount:globalFallbackCount unmatchedURLHandlerCount:unmatchedURLHandlerCount matchLatencyHistogram:matchLatencyHistogram routeMetrics:routeMetrics];
+}
+
+- (void)resetMetrics
+{
+    atomic_store_explicit(&_routingCount, 0, memory_order_relaxed);
+    atomic_store_explicit(&_missCount, 0, memory_order_relaxed);
+    atomic_store_explicit(&_globalFallbackCount, 0, memory_order_relaxed);
+    atomic_store_explicit(&_unmatchedURLHandlerCount, 0, memory_order_relaxed);
+    for (NSUInteger index = 0; index < JLRRouteMatchLatencyBucketCount; index++) {
+        atomic_store_explicit(&_matchLatencyBuckets[index], 0, memory_order_relaxed);
+    }
+    
+    for (JLRRouteDefinition *route in [self routes]) {
+        [route resetMetrics];
+    }
+}
+
+
+#pragma mark - Routing URLs
+
++ (BOOL)canRouteURL:(NSURL *)URL
+{
+    return [[self _routesControllerForURL:URL] canRouteURL:URL];
+}
+
+- (BOOL)canRouteURL:(NSURL *)URL
+{
+    return [self _routeURL:URL withParameters:nil executeRouteBlock:NO];
+}
+
++ (BOOL)routeURL:(NSURL *)URL
+{
+    return [[self _routesControllerForURL:URL] routeURL:URL];
+}
+
+- (BOOL)routeURL:(NSURL *)URL
+{
+    return [self _routeURL:URL withParameters:nil executeRouteBlock:YES];
+}
+
++ (BOOL)routeURL:(NSURL *)URL withParameters:(NSDictionary *)parameters
+{
+    return [[self _routesControllerForURL:URL] routeURL:URL withParameters:parameters];
+}
+
+- (BOOL)routeURL:(NSURL *)URL withParameters:(NSDictionary *)parameters
+{
+    return [self _routeURL:URL withParameters:parameters executeRouteBlock:YES];
+}
+
+@synthesize handlerQueue = _handlerQueue;
 
-+ (void)initialize
+- (void)setHandlerQueue:(dispatch_queue_t)handlerQueue
 {
-    if (self == [JLRoutes class]) {
-        // Set default global options
-        JLRGlobal_verboseLoggingEnabled = NO;
-        JLRGlobal_shouldDecodePlusSymbols = YES;
-        JLRGlobal_alwaysTreatsHostAsPathComponent = NO;
-        JLRGlobal_routeDefinitionClass = [JLRRouteDefinition class];
+    @synchronized (self) {
+        _handlerQueue = handlerQueue ?: dispatch_get_main_queue();
     }
 }
 
-- (instancetype)init
+- (dispatch_queue_t)handlerQueue
 {
-    if ((self = [super init])) {
-        self.mutableRoutes = [NSMutableArray array];
+    @synchronized (self) {
+        return _handlerQueue;
     }
-    return self;
 }
 
-- (NSString *)description
++ (void)routeURL:(NSURL *)URL withParameters:(NSDictionary *)parameters completion:(void (^)(BOOL didRoute))completion
 {
-    return [self.mutableRoutes description];
+    JLRoutes *routesController = [self _routesControllerForURL:URL] ?: [JLRoutes globalRoutes];
+    [routesController routeURL:URL withParameters:parameters completion:completion];
 }
 
-+ (NSDictionary <NSString *, NSArray <JLRRouteDefinition *> *> *)allRoutes;
+- (void)routeURL:(NSURL *)URL withParameters:(NSDictionary *)parameters completion:(void (^)(BOOL didRoute))completion
 {
-    NSMutableDictionary *dictionary = [NSMutableDictionary dictionary];
+    JLRAsyncRouteToken *token = [[JLRAsyncRouteToken alloc] init];
+    dispatch_queue_t handlerQueue = self.handlerQueue;
     
-    for (NSString *namespace in [JLRGlobal_routeControllersMap copy]) {
-        JLRoutes *routesController = JLRGlobal_routeControllersMap[namespace];
-        dictionary[namespace] = [routesController.mutableRoutes copy];
+    @synchronized (self) {
+        // only the newest URL routed asynchronously in a scheme is still routed
+        self.pendingAsyncRouteToken.cancelled = YES;
+        self.pendingAsyncRouteToken = token;
     }
     
-    return [dictionary copy];
+    void (^finish)(BOOL) = ^(BOOL didRoute) {
+        // a URL that was handled stays routed, even if a newer URL cancelled it while its handler was running
+        if (completion != nil) {
+            completion(didRoute);
+        }
+    };
+    
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        JLRRouteMatchCursor *cursor = nil;
+        
+        if (URL != nil && !token.isCancelled) {
+            // like routing synchronously, routes are only matched until one matches, and the rest only if its handler declines
+            cursor = [self _matchCursorForRequest:[self _routeRequestForURL:URL withParameters:parameters]];
+            [cursor findMatch];
+            
+            if (JLRGlobal_metricsEnabled) {
+                atomic_fetch_add_explicit(&self->_routingCount, 1, memory_order_relaxed);
+            }
+        }
+        
+        dispatch_async(handlerQueue, ^{
+            if (cursor == nil) {
+                finish(NO);
+            } else {
+                [self _routeMatchCursor:cursor token:token completion:finish];
+            }
+        });
+    });
 }
 
++ (JLRRouteMatch *)matchURL:(NSURL *)URL
+{
+    return [[self _routesControllerForURL:URL] matchURL:URL withParameters:nil];
+}
 
-#pragma mark - Routing Schemes
++ (JLRRouteMatch *)matchURL:(NSURL *)URL withParameters:(NSDictionary *)parameters
+{
+    return [[self _routesControllerForURL:URL] matchURL:URL withParameters:parameters];
+}
 
-+ (instancetype)globalRoutes
+- (JLRRouteMatch *)matchURL:(NSURL *)URL
 {
-    return [self routesForScheme:JLRoutesGlobalRoutesScheme];
+    return [self matchURL:URL withParameters:nil];
 }
 
-+ (instancetype)routesForScheme:(NSString *)scheme
+- (JLRRouteMatch *)matchURL:(NSURL *)URL withParameters:(NSDictionary *)parameters
 {
-    JLRoutes *routesController = nil;
-    
-    static dispatch_once_t onceToken;
-    dispatch_once(&onceToken, ^{
-        JLRGlobal_routeControllersMap = [[NSMutableDictionary alloc] init];
-    });
-    
-    if (!JLRGlobal_routeControllersMap[scheme]) {
-        routesController = [[self alloc] init];
-        routesController.scheme = scheme;
-        JLRGlobal_routeControllersMap[scheme] = routesController;
+    if (!URL) {
+        return nil;
     }
     
-    routesController = JLRGlobal_routeControllersMap[scheme];
-    
-    return routesController;
+    return [self _matchForRequest:[self _routeRequestForURL:URL withParameters:parameters]];
 }
 
-+ (void)unregisterRouteScheme:(NSString *)scheme
++ (BOOL)routeMatch:(JLRRouteMatch *)match
 {
-    [JLRGlobal_routeControllersMap removeObjectForKey:scheme];
+    if (match == nil) {
+        return NO;
+    }
+    
+    JLRRouteMatchCursor *cursor = [[JLRRouteMatchCursor alloc] initWithMatch:match];
+    return [match.routesController _routeMatchCursor:cursor executeRouteBlock:YES outcome:nil];
 }
 
-+ (void)unregisterAllRouteSchemes
++ (NSArray <NSNumber *> *)canRouteURLs:(NSArray <NSURL *> *)URLs
 {
-    [JLRGlobal_routeControllersMap removeAllObjects];
+    return [self _routeURLs:URLs withParameters:nil routesController:nil executeRouteBlock:NO];
 }
 
+- (NSArray <NSNumber *> *)canRouteURLs:(NSArray <NSURL *> *)URLs
+{
+    return [[self class] _routeURLs:URLs withParameters:nil routesController:self executeRouteBlock:NO];
+}
 
-#pragma mark - Registering Routes
++ (NSArray <NSNumber *> *)routeURLs:(NSArray <NSURL *> *)URLs withParameters:(NSDictionary *)parameters
+{
+    return [self _routeURLs:URLs withParameters:parameters routesController:nil executeRouteBlock:YES];
+}
 
-- (void)addRoute:(JLRRouteDefinition *)routeDefinition
+- (NSArray <NSNumber *> *)routeURLs:(NSArray <NSURL *> *)URLs withParameters:(NSDictionary *)parameters
 {
-    [self _registerRoute:routeDefinition];
+    return [[self class] _routeURLs:URLs withParameters:parameters routesController:self executeRouteBlock:YES];
 }
 
-- (void)addRoute:(NSString *)routePattern handler:(BOOL (^)(NSDictionary<NSString *, id> *parameters))handlerBlock
+
+#pragma mark - Private
+
++ (instancetype)_routesControllerForURL:(NSURL *)URL
 {
-    [self addRoute:routePattern priority:0 handler:handlerBlock];
+    if (URL == nil) {
+        return nil;
+    }
+    
+    return JLRGlobal_routeControllersRegistry.routeControllersMap[URL.scheme] ?: [JLRoutes globalRoutes];
 }
 
-- (void)addRoutes:(NSArray<NSString *> *)routePatterns handler:(BOOL (^)(NSDictionary<NSString *, id> *parameters))handlerBlock
+- (void)_registerRoute:(JLRRouteDefinition *)route
 {
-    for (NSString *routePattern in routePatterns) {
-        [self addRoute:routePattern handler:handlerBlock];
+    @synchronized (self) {
+        [route internStringsWithPool:self.stringPool];
+        [self _insertRoute:route];
+        [route didBecomeRegisteredForScheme:self.scheme];
+        [self _invalidateRouteIndex];
     }
 }
 
-- (void)addRoute:(NSString *)routePattern priority:(NSUInteger)priority handler:(BOOL (^)(NSDictionary<NSString *, id> *parameters))handlerBlock
+- (void)_insertRoute:(JLRRouteDefinition *)route
 {
-    NSArray <NSString *> *optionalRoutePatterns = [JLRParsingUtilities expandOptionalRoutePatternsForPattern:routePattern];
-    JLRRouteDefinition *route = [[JLRGlobal_routeDefinitionClass alloc] initWithPattern:routePattern priority:priority handlerBlock:handlerBlock];
+    [self _compactRoutes];
+    [self _addRouteToPatternIndex:route];
+    
+    // routes are ordered by descending priority, and a route goes after every route with the same or a higher priority
+    NSArray <JLRRouteDefinition *> *routes = self.mutableRoutes;
+    NSUInteger low = 0;
+    NSUInteger high = routes.count;
     
-    if (optionalRoutePatterns.count > 0) {
-        // there are optional params, parse and add them
-        for (NSString *pattern in optionalRoutePatterns) {
-            JLRRouteDefinition *optionalRoute = [[JLRGlobal_routeDefinitionClass alloc] initWithPattern:pattern priority:priority handlerBlock:handlerBlock];
-            [self _registerRoute:optionalRoute];
-            [self _verboseLog:@"Automatically created optional route: %@", optionalRoute];
+    while (low < high) {
+        NSUInteger middle = low + (high - low) / 2;
+        if (routes[middle].priority < route.priority) {
+            high = middle;
+        } else {
+            low = middle + 1;
         }
-        return;
     }
     
-    [self _registerRoute:route];
+    [self.mutableRoutes insertObject:route atIndex:low];
 }
 
-- (void)removeRoute:(JLRRouteDefinition *)routeDefinition
+- (void)_registerRoutes:(NSArray <JLRRouteDefinition *> *)routes replacingExistingRoutes:(BOOL)replacingExistingRoutes
 {
-    [self.mutableRoutes removeObject:routeDefinition];
+    // sorting doesn't depend on the existing routes, so it happens before taking the lock
+    NSArray <JLRRouteDefinition *> *sortedRoutes = [routes sortedArrayWithOptions:NSSortStable usingComparator:^NSComparisonResult(JLRRouteDefinition *route1, JLRRouteDefinition *route2) {
+        if (route1.priority == route2.priority) {
+            return NSOrderedSame;
+        }
+        return route1.priority > route2.priority ? NSOrderedAscending : NSOrderedDescending;
+    }];
+    
+    [self _registerSortedRoutes:sortedRoutes replacingExistingRoutes:replacingExistingRoutes];
 }
 
-- (void)removeRouteWithPattern:(NSString *)routePattern
-{   
-    NSInteger routeIndex = NSNotFound;
-    NSInteger index = 0;
-    
-    for (JLRRouteDefinition *route in [self.mutableRoutes copy]) {
-        if ([route.pattern isEqualToString:routePattern]) {
-            routeIndex = index;
-            break;
+- (void)_registerSortedRoutes:(NSArray <JLRRouteDefinition *> *)sortedRoutes replacingExistingRoutes:(BOOL)replacingExistingRoutes
+{
+    @synchronized (self) {
+        if (replacingExistingRoutes) {
+            [self.routesByPattern removeAllObjects];
+            [self.removedRoutes removeAllObjects];
+            self.stringPool = [[JLRRouteStringPool alloc] init];
+        } else {
+            [self _compactRoutes];
         }
-        index++;
-    }
-    
-    if (routeIndex != NSNotFound) {
-        [self.mutableRoutes removeObjectAtIndex:(NSUInteger)routeIndex];
+        
+        NSArray <JLRRouteDefinition *> *existingRoutes = replacingExistingRoutes ? @[] : self.mutableRoutes;
+        NSMutableArray <JLRRouteDefinition *> *mergedRoutes = [NSMutableArray arrayWithCapacity:existingRoutes.count + sortedRoutes.count];
+        NSUInteger existingIndex = 0;
+        NSUInteger sortedIndex = 0;
+        
+        // merge the two ordered lists, keeping existing routes ahead of new routes with the same priority
+        while (existingIndex < existingRoutes.count || sortedIndex < sortedRoutes.count) {
+            if (sortedIndex == sortedRoutes.count || (existingIndex < existingRoutes.count && existingRoutes[existingIndex].priority >= sortedRoutes[sortedIndex].priority)) {
+                [mergedRoutes addObject:existingRoutes[existingIndex++]];
+            } else {
+                [mergedRoutes addObject:sortedRoutes[sortedIndex++]];
+            }
+        }
+        
+        for (JLRRouteDefinition *route in sortedRoutes) {
+            [route internStringsWithPool:self.stringPool];
+            [self _addRouteToPatternIndex:route];
+            [route didBecomeRegisteredForScheme:self.scheme];
+        }
+        
+        // routing only ever sees the route index built from the old or the new table, never a table in between
+        self.mutableRoutes = mergedRoutes;
+        [self _invalidateRouteIndex];
     }
 }
 
-- (void)removeAllRoutes
+- (void)_addRouteToPatternIndex:(JLRRouteDefinition *)route
 {
-    [self.mutableRoutes removeAllObjects];
+    // must be called while synchronized on self
+    NSMutableArray <JLRRouteDefinition *> *routes = self.routesByPattern[route.pattern];
+    
+    if (routes == nil) {
+        routes = [NSMutableArray arrayWithCapacity:1];
+        self.routesByPattern[route.pattern] = routes;
+    }
+    
+    [routes addObject:route];
 }
 
-- (void)setObject:(id)handlerBlock forKeyedSubscript:(NSString *)routePatten
+- (void)_removeRoutesAtIndexes:(NSIndexSet *)indexes withPattern:(NSString *)routePattern
 {
-    [self addRoute:routePatten handler:handlerBlock];
+    // must be called while synchronized on self. The routes stay in mutableRoutes until it is compacted, so removing
+    // one is a lookup by pattern instead of a scan of every route.
+    NSMutableArray <JLRRouteDefinition *> *routes = self.routesByPattern[routePattern];
+    
+    for (JLRRouteDefinition *route in [routes objectsAtIndexes:indexes]) {
+        [self.removedRoutes addObject:route];
+    }
+    
+    [routes removeObjectsAtIndexes:indexes];
+    if (routes.count == 0) {
+        [self.routesByPattern removeObjectForKey:routePattern];
+    }
+    
+    [self _invalidateRouteIndex];
 }
 
-- (NSArray <JLRRouteDefinition *> *)routes;
+- (void)_compactRoutes
 {
-    return [self.mutableRoutes copy];
+    // must be called while synchronized on self. Removals since the last compaction are dropped in a single pass.
+    if (self.removedRoutes.count == 0) {
+        return;
+    }
+    
+    NSMutableArray <JLRRouteDefinition *> *routes = [NSMutableArray arrayWithCapacity:self.mutableRoutes.count];
+    for (JLRRouteDefinition *route in self.mutableRoutes) {
+        if (![self.removedRoutes containsObject:route]) {
+            [routes addObject:route];
+        }
+    }
+    
+    self.mutableRoutes = routes;
+    [self.removedRoutes removeAllObjects];
 }
 
-#pragma mark - Routing URLs
-
-+ (BOOL)canRouteURL:(NSURL *)URL
+- (JLRRouteIndex *)_currentRouteIndex
 {
-    return [[self _routesControllerForURL:URL] canRouteURL:URL];
+    JLRRouteIndex *routeIndex = self.routeIndex;
+    
+    if (routeIndex == nil) {
+        // the routes changed since the last index was built, so build and publish a new one
+        @synchronized (self) {
+            routeIndex = self.routeIndex;
+            if (routeIndex == nil) {
+                [self _compactRoutes];
+                NSArray <JLRRouteDefinition *> *routes = [self.mutableRoutes copy];
+                NSHashTable <JLRRouteDefinition *> *excludedRoutes = nil;
+                
+                if (_prunesShadowedRoutes) {
+                    // shadowed routes are only ever tried after a handler declines, which pruning gives up on
+                    self.shadowedRouteAnalysis = [JLRShadowedRoute shadowedRoutesInRoutes:routes];
+                    excludedRoutes = [NSHashTable hashTableWithOptions:NSPointerFunctionsObjectPointerPersonality];
+                    for (JLRShadowedRoute *shadowedRoute in self.shadowedRouteAnalysis) {
+                        [excludedRoutes addObject:shadowedRoute.route];
+                    }
+                }
+                
+                routeIndex = [[JLRRouteIndex alloc] initWithRoutes:routes excludedRoutes:excludedRoutes];
+                self.routeIndex = routeIndex;
+            }
+        }
+    }
+    
+    return routeIndex;
 }
 
-- (BOOL)canRouteURL:(NSURL *)URL
+- (void)_invalidateRouteIndex
 {
-    return [self _routeURL:URL withParameters:nil executeRouteBlock:NO];
+    // must be called while synchronized on self, after mutating mutableRoutes
+    self.routeIndex = nil;
+    self.shadowedRouteAnalysis = nil;
+    [self.resolutionCache removeAllResolutions];
 }
 
-+ (BOOL)routeURL:(NSURL *)URL
+- (BOOL)_routeURL:(NSURL *)URL withParameters:(NSDictionary *)parameters executeRouteBlock:(BOOL)executeRouteBlock
 {
-    return [[self _routesControllerForURL:URL] routeURL:URL];
+    if (!URL) {
+        return NO;
+    }
+    
+    JLRRouteRequest *request = [self _routeRequestForURL:URL withParameters:parameters];
+    JLRRouteRecorder *routeRecorder = executeRouteBlock ? JLRGlobal_routeObservers.routeRecorder : nil;
+    
+    if (routeRecorder == nil) {
+        return [self _routeRequest:request executeRouteBlock:executeRouteBlock outcome:nil];
+    }
+    
+    JLRRouteOutcome *outcome = [[JLRRouteOutcome alloc] init];
+    uint64_t startTime = JLRMonotonicNanoseconds();
+    BOOL didRoute = [self _routeRequest:request executeRouteBlock:YES outcome:outcome];
+    uint64_t duration = JLRMonotonicNanoseconds() - startTime;
+    
+    [routeRecorder recordURL:URL additionalParameters:parameters scheme:self.scheme routePattern:outcome.route.pattern didRoute:didRoute declinedHandlerCount:outcome.declinedHandlerCount duration:duration];
+    
+    return didRoute;
 }
 
-- (BOOL)routeURL:(NSURL *)URL
+- (BOOL)_routeRequest:(JLRRouteRequest *)request executeRouteBlock:(BOOL)executeRouteBlock outcome:(nullable JLRRouteOutcome *)outcome
 {
-    return [self _routeURL:URL withParameters:nil executeRouteBlock:YES];
+    BOOL recordsMetrics = JLRGlobal_metricsEnabled;
+    uint64_t startTime = recordsMetrics ? JLRMonotonicNanoseconds() : 0;
+    
+    JLRRouteMatchCursor *cursor = [self _matchCursorForRequest:request];
+    
+    if (recordsMetrics) {
+        [cursor findMatch];
+        [self _recordMatchLatency:JLRMonotonicNanoseconds() - startTime];
+    }
+    
+    return [self _routeMatchCursor:cursor executeRouteBlock:executeRouteBlock outcome:outcome];
 }
 
-+ (BOOL)routeURL:(NSURL *)URL withParameters:(NSDictionary *)parameters
+- (JLRRouteRequest *)_routeRequestForURL:(NSURL *)URL withParameters:(NSDictionary *)parameters
 {
-    return [[self _routesControllerForURL:URL] routeURL:URL withParameters:parameters];
+    return [[JLRRouteRequest alloc] initWithURL:URL options:[self _routeRequestOptions] additionalParameters:parameters];
 }
 
-- (BOOL)routeURL:(NSURL *)URL withParameters:(NSDictionary *)parameters
+- (JLRRouteMatchCursor *)_matchCursorForRequest:(JLRRouteRequest *)request
 {
-    return [self _routeURL:URL withParameters:parameters executeRouteBlock:YES];
+    JLRTrace(self, JLRRouteTraceEventWillRouteURL, request.URL, nil, nil);
+    
+    JLRRouteIndex *routeIndex = [self _currentRouteIndex];
+    
+    if (![routeIndex mayMatchRequest:request]) {
+        // a definite miss, which is decided from the raw path components before creating strings for them
+        return [[JLRRouteMatchCursor alloc] initWithRequest:request candidateRoutes:@[] routeVariables:nil];
+    }
+    
+    JLRRouteResolution *resolution = [self _resolutionForRequest:request routeIndex:routeIndex];
+    
+    // without a resolution, only the routes whose pattern could match the request's path components need to be checked
+    NSArray <JLRRouteDefinition *> *candidateRoutes = resolution.routes ?: [routeIndex candidateRoutesForRequest:request];
+    
+    return [[JLRRouteMatchCursor alloc] initWithRequest:request candidateRoutes:candidateRoutes routeVariables:resolution.routeVariables];
 }
 
-
-#pragma mark - Private
-
-+ (instancetype)_routesControllerForURL:(NSURL *)URL
+- (JLRRouteMatch *)_matchForRequest:(JLRRouteRequest *)request
 {
-    if (URL == nil) {
-        return nil;
+    JLRRouteMatchCursor *cursor = [self _matchCursorForRequest:request];
+    NSMutableArray <JLRRouteDefinition *> *routes = [NSMutableArray array];
+    NSMutableArray <NSDictionary *> *parameters = [NSMutableArray array];
+    
+    for (; [cursor findMatch]; [cursor skipMatch]) {
+        [routes addObject:cursor.route];
+        [parameters addObject:cursor.response.parameters];
+    }
+    
+    JLRRouteMatch * (^globalRoutesMatchProvider)(void) = nil;
+    
+    if (self.shouldFallbackToGlobalRoutes && ![self _isGlobalRoutesController]) {
+        // the global routes are matched against the same request, so the URL is only parsed once
+        globalRoutesMatchProvider = ^JLRRouteMatch * {
+            return [[JLRoutes globalRoutes] _matchForRequest:request];
+        };
     }
     
-    return JLRGlobal_routeControllersMap[URL.scheme] ?: [JLRoutes globalRoutes];
+    return [[JLRRouteMatch alloc] initWithRoutesController:self request:request routes:routes parameters:parameters globalRoutesMatchProvider:globalRoutesMatchProvider];
 }
 
-- (void)_registerRoute:(JLRRouteDefinition *)route
+- (void)_routeMatchCursor:(JLRRouteMatchCursor *)cursor token:(JLRAsyncRouteToken *)token completion:(void (^)(BOOL didRoute))completion
 {
-    if (route.priority == 0 || self.mutableRoutes.count == 0) {
-        [self.mutableRoutes addObject:route];
-    } else {
-        NSUInteger index = 0;
-        BOOL addedRoute = NO;
-        
-        // search through existing routes looking for a lower priority route than this one
-        for (JLRRouteDefinition *existingRoute in [self.mutableRoutes copy]) {
-            if (existingRoute.priority < route.priority) {
-                // if found, add the route after it
-                [self.mutableRoutes insertObject:route atIndex:index];
-                addedRoute = YES;
-                break;
+    // must be called on handlerQueue, once the cursor has looked for its next match. Mirrors -_routeMatchCursor:executeRouteBlock:outcome:, one handler at a time.
+    if (token.isCancelled) {
+        completion(NO);
+        return;
+    }
+    
+    BOOL recordsMetrics = JLRGlobal_metricsEnabled;
+    dispatch_queue_t handlerQueue = self.handlerQueue;
+    NSURL *URL = cursor.request.URL;
+    
+    if (cursor.response != nil) {
+        JLRRouteDefinition *route = cursor.route;
+        NSDictionary *parameters = cursor.response.parameters;
+        uint64_t handlerStartTime = recordsMetrics ? JLRMonotonicNanoseconds() : 0;
+        
+        JLRTrace(self, JLRRouteTraceEventDidMatchRoute, URL, route, parameters);
+        
+        [route callHandlerBlockWithParameters:parameters completion:^(BOOL handled) {
+            if (recordsMetrics) {
+                [route recordHandlerResult:handled duration:JLRMonotonicNanoseconds() - handlerStartTime];
             }
-            index++;
-        }
+            
+            if (handled) {
+                dispatch_async(handlerQueue, ^{
+                    completion(YES);
+                });
+                return;
+            }
+            
+            JLRTrace(self, JLRRouteTraceEventHandlerDidDecline, URL, route, parameters);
+            
+            // the next match is looked for in the background too, so that handlerQueue only ever calls handlers
+            dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+                [cursor skipMatch];
+                [cursor findMatch];
+                
+                dispatch_async(handlerQueue, ^{
+                    [self _routeMatchCursor:cursor token:token completion:completion];
+                });
+            });
+        }];
+        return;
+    }
+    
+    JLRTrace(self, JLRRouteTraceEventDidNotRouteURL, URL, nil, nil);
+    if (recordsMetrics) {
+        atomic_fetch_add_explicit(&_missCount, 1, memory_order_relaxed);
+    }
+    
+    void (^finish)(BOOL) = ^(BOOL didRoute) {
+        void (^unmatchedURLHandler)(JLRoutes *, NSURL *, NSDictionary *) = self.unmatchedURLHandler;
         
-        // if we weren't able to find a lower priority route, this is the new lowest priority route (or same priority as self.routes.lastObject) and should just be added
-        if (!addedRoute) {
-            [self.mutableRoutes addObject:route];
+        if (!didRoute && !token.isCancelled && unmatchedURLHandler != nil) {
+            JLRTrace(self, JLRRouteTraceEventWillCallUnmatchedURLHandler, URL, nil, nil);
+            if (recordsMetrics) {
+                atomic_fetch_add_explicit(&self->_unmatchedURLHandlerCount, 1, memory_order_relaxed);
+            }
+            unmatchedURLHandler(self, URL, cursor.request.additionalParameters);
         }
+        
+        completion(didRoute);
+    };
+    
+    if (!self.shouldFallbackToGlobalRoutes || [self _isGlobalRoutesController]) {
+        finish(NO);
+        return;
+    }
+    
+    JLRTrace(self, JLRRouteTraceEventWillFallBackToGlobalRoutes, URL, nil, nil);
+    if (recordsMetrics) {
+        atomic_fetch_add_explicit(&_globalFallbackCount, 1, memory_order_relaxed);
     }
     
-    [route didBecomeRegisteredForScheme:self.scheme];
+    JLRoutes *globalRoutes = [JLRoutes globalRoutes];
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        // reuse the request, which has already parsed the URL
+        JLRRouteMatchCursor *globalRoutesCursor = [globalRoutes _matchCursorForRequest:cursor.request];
+        [globalRoutesCursor findMatch];
+        
+        if (recordsMetrics) {
+            atomic_fetch_add_explicit(&globalRoutes->_routingCount, 1, memory_order_relaxed);
+        }
+        
+        dispatch_async(globalRoutes.handlerQueue, ^{
+            [globalRoutes _routeMatchCursor:globalRoutesCursor token:token completion:^(BOOL didRoute) {
+                dispatch_async(handlerQueue, ^{
+                    finish(didRoute);
+                });
+            }];
+        });
+    });
 }
 
-- (BOOL)_routeURL:(NSURL *)URL withParameters:(NSDictionary *)parameters executeRouteBlock:(BOOL)executeRouteBlock
+- (BOOL)_routeMatchCursor:(JLRRouteMatchCursor *)cursor executeRouteBlock:(BOOL)executeRouteBlock outcome:(nullable JLRRouteOutcome *)outcome
 {
-    if (!URL) {
-        return NO;
-    }
-    
-    [self _verboseLog:@"Trying to route URL %@", URL];
-    
+    NSURL *URL = cursor.request.URL;
+    NSDictionary *parameters = cursor.request.additionalParameters;
+    BOOL recordsMetrics = JLRGlobal_metricsEnabled;
     BOOL didRoute = NO;
     
-    JLRRouteRequestOptions options = [self _routeRequestOptions];
-    JLRRouteRequest *request = [[JLRRouteRequest alloc] initWithURL:URL options:options additionalParameters:parameters];
+    if (recordsMetrics) {
+        atomic_fetch_add_explicit(&_routingCount, 1, memory_order_relaxed);
+    }
     
-    for (JLRRouteDefinition *route in [self.mutableRoutes copy]) {
-        // check each route for a matching response
-        JLRRouteResponse *response = [route routeResponseForRequest:request];
-        if (!response.isMatch) {
-            continue;
-        }
+    while ([cursor findMatch]) {
+        JLRRouteDefinition *route = cursor.route;
+        JLRRouteResponse *response = cursor.response;
         
-        [self _verboseLog:@"Successfully matched %@", route];
+        JLRTrace(self, JLRRouteTraceEventDidMatchRoute, URL, route, response.parameters);
         
         if (!executeRouteBlock) {
             // if we shouldn't execute but it was a match, we're done now
             return YES;
         }
         
-        [self _verboseLog:@"Match parameters are %@", response.parameters];
-        
         // Call the handler block
+        uint64_t handlerStartTime = recordsMetrics ? JLRMonotonicNanoseconds() : 0;
         didRoute = [route callHandlerBlockWithParameters:response.parameters];
         
+        if (recordsMetrics) {
+            [route recordHandlerResult:didRoute duration:JLRMonotonicNanoseconds() - handlerStartTime];
+        }
+        
         if (didRoute) {
             // if it was routed successfully, we're done - otherwise, continue trying to route
+            outcome.route = route;
+            if (self.adaptiveOrderingEnabled) {
+                [self _recordOrderingHitForRoute:route];
+            }
             break;
         }
+        
+        JLRTrace(self, JLRRouteTraceEventHandlerDidDecline, URL, route, response.parameters);
+        outcome.declinedHandlerCount++;
+        [cursor skipMatch];
     }
     
     if (!didRoute) {
-        [self _verboseLog:@"Could not find a matching route"];
+        JLRTrace(self, JLRRouteTraceEventDidNotRouteURL, URL, nil, nil);
+        if (recordsMetrics) {
+            atomic_fetch_add_explicit(&_missCount, 1, memory_order_relaxed);
+        }
     }
     
     // if we couldn't find a match and this routes controller specifies to fallback and its also not the global routes controller, then...
     if (!didRoute && self.shouldFallbackToGlobalRoutes && ![self _isGlobalRoutesController]) {
-        [self _verboseLog:@"Falling back to global routes..."];
-        didRoute = [[JLRoutes globalRoutes] _routeURL:URL withParameters:parameters executeRouteBlock:executeRouteBlock];
+        JLRTrace(self, JLRRouteTraceEventWillFallBackToGlobalRoutes, URL, nil, nil);
+        if (recordsMetrics) {
+            atomic_fetch_add_explicit(&_globalFallbackCount, 1, memory_order_relaxed);
+        }
+        JLRRouteMatch *globalRoutesMatch = cursor.match.globalRoutesMatch;
+        
+        if (globalRoutesMatch != nil) {
+            JLRRouteMatchCursor *globalRoutesCursor = [[JLRRouteMatchCursor alloc] initWithMatch:globalRoutesMatch];
+            didRoute = [globalRoutesMatch.routesController _routeMatchCursor:globalRoutesCursor executeRouteBlock:executeRouteBlock outcome:outcome];
+        } else {
+            // reuse the request, which has already parsed the URL
+            didRoute = [[JLRoutes globalRoutes] _routeRequest:cursor.request executeRouteBlock:executeRouteBlock outcome:outcome];
+        }
     }
     
     // if, after everything, we did not route anything and we have an unmatched URL handler, then call it
     if (!didRoute && executeRouteBlock && self.unmatchedURLHandler) {
-        [self _verboseLog:@"Falling back to the unmatched URL handler"];
+        JLRTrace(self, JLRRouteTraceEventWillCallUnmatchedURLHandler, URL, nil, nil);
+        if (recordsMetrics) {
+            atomic_fetch_add_explicit(&_unmatchedURLHandlerCount, 1, memory_order_relaxed);
+        }
         self.unmatchedURLHandler(self, URL, parameters);
     }
     
     return didRoute;
 }
 
-- (BOOL)_isGlobalRoutesController
++ (NSArray <NSNumber *> *)_routeURLs:(NSArray <NSURL *> *)URLs withParameters:(NSDictionary *)parameters routesController:(JLRoutes *)routesController executeRouteBlock:(BOOL)executeRouteBlock
 {
-    return [self.scheme isEqualToString:JLRoutesGlobalRoutesScheme];
+    NSUInteger count = URLs.count;
+    JLRoutes * __strong *routesControllers = (JLRoutes * __strong *)calloc(count, sizeof(JLRoutes *));
+    JLRRouteMatchCursor * __strong *cursors = (JLRRouteMatchCursor * __strong *)calloc(count, sizeof(JLRRouteMatchCursor *));
+    JLRRouteRecorder *routeRecorder = executeRouteBlock ? JLRGlobal_routeObservers.routeRecorder : nil;
+    uint64_t *matchDurations = (routeRecorder != nil) ? (uint64_t *)calloc(count, sizeof(uint64_t)) : NULL;
+    
+    // parsing each URL and finding its first match doesn't depend on any other URL, so spread that work across cores
+    dispatch_apply(count, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t index) {
+        @autoreleasepool {
+            NSURL *URL = URLs[index];
+            JLRoutes *controller = routesController ?: [self _routesControllerForURL:URL];
+            BOOL recordsMetrics = JLRGlobal_metricsEnabled;
+            uint64_t startTime = (recordsMetrics || matchDurations != NULL) ? JLRMonotonicNanoseconds() : 0;
+            
+            JLRRouteMatchCursor *cursor = [controller _matchCursorForRequest:[controller _routeRequestForURL:URL withParameters:parameters]];
+            [cursor findMatch];
+            
+            if (recordsMetrics || matchDurations != NULL) {
+                uint64_t matchDuration = JLRMonotonicNanoseconds() - startTime;
+                if (recordsMetrics) {
+                    [controller _recordMatchLatency:matchDuration];
+                }
+                if (matchDurations != NULL) {
+                    matchDurations[index] = matchDuration;
+                }
+            }
+            
+            routesControllers[index] = controller;
+            cursors[index] = cursor;
+        }
+    });
+    
+    // handlers (and anything else with side effects) run here on the calling thread, in the order the URLs were given
+    NSMutableArray <NSNumber *> *results = [NSMutableArray arrayWithCapacity:count];
+    
+    for (NSUInteger index = 0; index < count; index++) {
+        if (routeRecorder == nil) {
+            BOOL didRoute = [routesControllers[index] _routeMatchCursor:cursors[index] executeRouteBlock:executeRouteBlock outcome:nil];
+            [results addObject:@(didRoute)];
+        } else {
+            // the recorded duration is the time taken to match (on whichever thread did it) plus the time taken here
+            JLRRouteOutcome *outcome = [[JLRRouteOutcome alloc] init];
+            uint64_t startTime = JLRMonotonicNanoseconds();
+            BOOL didRoute = [routesControllers[index] _routeMatchCursor:cursors[index] executeRouteBlock:YES outcome:outcome];
+            uint64_t duration = matchDurations[index] + JLRMonotonicNanoseconds() - startTime;
+            
+            [routeRecorder recordURL:URLs[index] additionalParameters:parameters scheme:routesControllers[index].scheme routePattern:outcome.route.pattern didRoute:didRoute declinedHandlerCount:outcome.declinedHandlerCount duration:duration];
+            [results addObject:@(didRoute)];
+        }
+        
+        routesControllers[index] = nil;
+        cursors[index] = nil;
+    }
+    
+    free(routesControllers);
+    free(cursors);
+    free(matchDurations);
+    
+    return [results copy];
 }
 
-- (void)_verboseLog:(NSString *)format, ...
+- (nullable JLRRouteResolution *)_resolutionForRequest:(JLRRouteRequest *)request routeIndex:(JLRRouteIndex *)routeIndex
 {
-    if (!JLRGlobal_verboseLoggingEnabled || format.length == 0) {
-        return;
+    JLRResolutionCache *resolutionCache = self.resolutionCache;
+    
+    if (resolutionCache == nil) {
+        return nil;
+    }
+    
+    // the options are part of the key since they change both the path components and the route variables
+    NSString *key = [NSString stringWithFormat:@"%lu:%@", (unsigned long)request.options, [request.pathComponents componentsJoinedByString:@"/"]];
+    
+    if (routeIndex.constrainsSchemesOrHosts) {
+        // the candidates were also filtered by scheme and host, so the same path can resolve differently on another one
+        key = [NSString stringWithFormat:@"%@://%@/%@", [request.URL.scheme lowercaseString] ?: @"", [request.URL.host lowercaseString] ?: @"", key];
+    }
+    JLRRouteResolution *resolution = [resolutionCache resolutionForKey:key routeIndex:routeIndex];
+    
+    if (resolution != nil) {
+        return resolution;
     }
     
-    va_list argsList;
-    va_start(argsList, format);
-#pragma clang diagnostic push
-#pragma clang diagnostic ignored "-Wformat-nonliteral"
-    NSString *formattedLogMessage = [[NSString alloc] initWithFormat:format arguments:argsList];
-#pragma clang diagnostic pop
+    NSMutableArray <JLRRouteDefinition *> *routes = [NSMutableArray array];
+    NSMutableArray *routeVariables = [NSMutableArray array];
+    
+    for (JLRRouteDefinition *route in [routeIndex candidateRoutesForRequest:request]) {
+        if (![JLRRouteIndex canIndexRoute:route]) {
+            // custom matching logic might depend on more than the path, so it has to be checked every time
+            [routes addObject:route];
+            [routeVariables addObject:[NSNull null]];
+            continue;
+        }
+        
+        NSDictionary *variables = [route routeVariablesForRequest:request];
+        if (variables != nil) {
+            [routes addObject:route];
+            [routeVariables addObject:variables];
+        }
+    }
+    
+    resolution = [[JLRRouteResolution alloc] initWithRoutes:routes routeVariables:routeVariables];
+    [resolutionCache setResolution:resolution forKey:key routeIndex:routeIndex];
+    
+    return resolution;
+}
+
++ (void)_removeAllResolutionsForAllSchemes
+{
+    // cached resolutions already can't be reused under different options, but they'd never be used again either
+    NSDictionary <NSString *, JLRoutes *> *routeControllersMap = JLRGlobal_routeControllersRegistry.routeControllersMap;
     
-    va_end(argsList);
-    NSLog(@"[JLRoutes]: %@", formattedLogMessage);
+    for (NSString *scheme in routeControllersMap) {
+        [routeControllersMap[scheme].resolutionCache removeAllResolutions];
+    }
+}
+
+- (BOOL)_isGlobalRoutesController
+{
+    return [self.scheme isEqualToString:JLRoutesGlobalRoutesScheme];
+}
+
+- (void)_recordMatchLatency:(uint64_t)nanoseconds
+{
+    // bucket i holds latencies in [2^i, 2^(i+1)) nanoseconds
+    NSUInteger bucket = nanoseconds == 0 ? 0 : (NSUInteger)(63 - __builtin_clzll(nanoseconds));
+    bucket = MIN(bucket, JLRRouteMatchLatencyBucketCount - 1);
+    atomic_fetch_add_explicit(&_matchLatencyBuckets[bucket], 1, memory_order_relaxed);
 }
 
 - (JLRRouteRequestOptions)_routeRequestOptions
@@ -370,7 +1505,10 @@ static Class JLRGlobal_routeDefinitionClass;
 
 + (void)setVerboseLoggingEnabled:(BOOL)loggingEnabled
 {
-    JLRGlobal_verboseLoggingEnabled = loggingEnabled;
+    @synchronized (JLRGlobal_routeObservers) {
+        JLRGlobal_verboseLoggingEnabled = loggingEnabled;
+        JLRUpdateActiveTraceSink();
+    }
 }
 
 + (BOOL)isVerboseLoggingEnabled
@@ -378,9 +1516,43 @@ static Class JLRGlobal_routeDefinitionClass;
     return JLRGlobal_verboseLoggingEnabled;
 }
 
++ (void)setTraceSink:(id <JLRRouteTraceSink>)traceSink
+{
+    @synchronized (JLRGlobal_routeObservers) {
+        JLRGlobal_routeObservers.traceSink = traceSink;
+        JLRUpdateActiveTraceSink();
+    }
+}
+
++ (id <JLRRouteTraceSink>)traceSink
+{
+    return JLRGlobal_routeObservers.traceSink;
+}
+
++ (void)setMetricsEnabled:(BOOL)metricsEnabled
+{
+    JLRGlobal_metricsEnabled = metricsEnabled;
+}
+
++ (BOOL)isMetricsEnabled
+{
+    return JLRGlobal_metricsEnabled;
+}
+
++ (void)setRouteRecorder:(JLRRouteRecorder *)routeRecorder
+{
+    JLRGlobal_routeObservers.routeRecorder = routeRecorder;
+}
+
++ (JLRRouteRecorder *)routeRecorder
+{
+    return JLRGlobal_routeObservers.routeRecorder;
+}
+
 + (void)setShouldDecodePlusSymbols:(BOOL)shouldDecode
 {
     JLRGlobal_shouldDecodePlusSymbols = shouldDecode;
+    [self _removeAllResolutionsForAllSchemes];
 }
 
 + (BOOL)shouldDecodePlusSymbols
@@ -391,6 +1563,7 @@ static Class JLRGlobal_routeDefinitionClass;
 + (void)setAlwaysTreatsHostAsPathComponent:(BOOL)treatsHostAsPathComponent
 {
     JLRGlobal_alwaysTreatsHostAsPathComponent = treatsHostAsPathComponent;
+    [self _removeAllResolutionsForAllSchemes];
 }
 
 + (BOOL)alwaysTreatsHostAsPathComponent